@@ -0,0 +1,135 @@
+#include "boot_timeline.h"
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_app_desc.h" // firmware version
+#endif
+
+#include <stdio.h>
+
+static const char *const s_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_APP_MAIN] = "app_main",
+    [BOOT_PHASE_NVS_ERASE] = "nvs_erase",
+    [BOOT_PHASE_NVS_INIT] = "nvs_init",
+    [BOOT_PHASE_NETIF_INIT] = "netif_init",
+    [BOOT_PHASE_EVENT_LOOP] = "event_loop",
+    [BOOT_PHASE_WIFI_INIT] = "wifi_init",
+    [BOOT_PHASE_WIFI_START] = "wifi_start",
+    [BOOT_PHASE_ASSOCIATED] = "associated",
+    [BOOT_PHASE_GOT_IP] = "got_ip",
+    [BOOT_PHASE_SOCKET_BOUND] = "socket_bound",
+};
+
+static int64_t s_marks_us[BOOT_PHASE_COUNT]; // 0: phase not reached
+static const char *s_note = "";
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void boot_timeline_mark(boot_phase_t phase)
+{
+    int64_t now = esp_timer_get_time();
+    if (phase >= BOOT_PHASE_COUNT)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (s_marks_us[phase] == 0)
+    {
+        s_marks_us[phase] = now;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_timeline_set_note(const char *note)
+{
+    s_note = note ? note : "";
+}
+
+static const char *firmware_version(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return "host";
+#else
+    return esp_app_get_description()->version;
+#endif
+}
+
+// Copy the reached phases, in the order they ended. Returns how many there are
+static int sorted_marks(boot_phase_t *phases, int64_t *marks_us)
+{
+    int64_t copy[BOOT_PHASE_COUNT];
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        copy[i] = s_marks_us[i];
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    int count = 0;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        if (copy[i] == 0)
+        {
+            continue;
+        }
+        int j = count++;
+        for (; j > 0 && marks_us[j - 1] > copy[i]; j--) // insertion sort, there are only a few
+        {
+            phases[j] = phases[j - 1];
+            marks_us[j] = marks_us[j - 1];
+        }
+        phases[j] = (boot_phase_t)i;
+        marks_us[j] = copy[i];
+    }
+    return count;
+}
+
+void boot_timeline_print(void)
+{
+    boot_phase_t phases[BOOT_PHASE_COUNT];
+    int64_t marks_us[BOOT_PHASE_COUNT];
+    int count = sorted_marks(phases, marks_us);
+
+    printf("Boot timeline, firmware %s%s%s\n", firmware_version(), s_note[0] ? ", " : "", s_note);
+    printf("  %-14s %10s %10s\n", "phase", "at ms", "took ms");
+    int64_t prev_us = 0;
+    for (int i = 0; i < count; i++)
+    {
+        printf("  %-14s %10.1f %10.1f\n", s_names[phases[i]], marks_us[i] / 1000.0, (marks_us[i] - prev_us) / 1000.0);
+        prev_us = marks_us[i];
+    }
+}
+
+size_t boot_timeline_format_json(const char *device_id, char *buf, size_t size)
+{
+    boot_phase_t phases[BOOT_PHASE_COUNT];
+    int64_t marks_us[BOOT_PHASE_COUNT];
+    int count = sorted_marks(phases, marks_us);
+
+    int n = snprintf(buf, size, "{\"id\":\"%s\",\"status\":\"boot\",\"fw\":\"%s\",\"note\":\"%s\",\"phases_us\":{",
+                     device_id, firmware_version(), s_note);
+    if (n < 0 || (size_t)n >= size)
+    {
+        return 0;
+    }
+    size_t len = n;
+    for (int i = 0; i <= count; i++)
+    {
+        if (i < count)
+        {
+            n = snprintf(buf + len, size - len, "%s\"%s\":%lld", i ? "," : "", s_names[phases[i]], (long long)marks_us[i]);
+        }
+        else
+        {
+            n = snprintf(buf + len, size - len, "}}");
+        }
+        if (n < 0 || len + n >= size)
+        {
+            return 0;
+        }
+        len += n;
+    }
+    return len;
+}
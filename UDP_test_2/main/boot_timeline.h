@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Boot phase timestamps, to see where the time from reset to a bound command socket goes.
+//
+// A mark takes the esp_timer time the phase ended at into a fixed slot, nothing is printed or
+// allocated, so it can sit in the event handlers. Only the first mark of a phase counts, a later
+// reconnect doesn't move it. Phases that didn't happen (no NVS erase, no Wi-Fi on the linux target)
+// are left out of the dump.
+
+typedef enum
+{
+    BOOT_PHASE_APP_MAIN,     // app_main entered, the ROM and IDF startup before it
+    BOOT_PHASE_NVS_ERASE,    // NVS partition erased after a failed init
+    BOOT_PHASE_NVS_INIT,     // nvs_flash_init() returned
+    BOOT_PHASE_NETIF_INIT,   // esp_netif_init() returned
+    BOOT_PHASE_EVENT_LOOP,   // default event loop created
+    BOOT_PHASE_WIFI_INIT,    // esp_wifi_init() returned
+    BOOT_PHASE_WIFI_START,   // esp_wifi_start() returned
+    BOOT_PHASE_ASSOCIATED,   // WIFI_EVENT_STA_CONNECTED
+    BOOT_PHASE_GOT_IP,       // IP_EVENT_STA_GOT_IP
+    BOOT_PHASE_SOCKET_BOUND, // command socket bound
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+// Record the current time as the end of phase, if it isn't recorded yet. Safe from any task
+void boot_timeline_mark(boot_phase_t phase);
+
+// Short free text shown with the timeline, e.g. how Wi-Fi connected. note must stay valid
+void boot_timeline_set_note(const char *note);
+
+// Print the recorded phases as a table, in the order they ended
+void boot_timeline_print(void);
+
+// Write the timeline as a JSON telemetry datagram:
+// {"id":"ESP32_A1B2C3","status":"boot","fw":"1.0","note":"scan","phases_us":{"app_main":312000,...}}
+// Returns its length, or 0 if buf is too small
+size_t boot_timeline_format_json(const char *device_id, char *buf, size_t size);
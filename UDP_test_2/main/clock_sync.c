@@ -0,0 +1,149 @@
+#include "clock_sync.h"
+
+#include "freertos/FreeRTOS.h"
+
+#define CLOCK_SYNC_WINDOW 8                           // recent samples the best one is picked from
+#define CLOCK_SYNC_MAX_AGE_US (30 * 1000000LL)        // older samples are no longer picked
+#define CLOCK_SYNC_DRIFT_MIN_SPAN_US (2 * 1000000LL)  // shortest span a drift is measured over
+#define CLOCK_SYNC_MAX_DRIFT_PPM 500.0                // anything larger is a measurement error
+
+typedef struct
+{
+    int64_t local_us; // local time the sample was completed at (t2)
+    int64_t offset_us;
+    int64_t delay_us;
+} sync_sample_t;
+
+// Exchange in progress, only the latest SYNC is answered
+static struct
+{
+    uint32_t seq;
+    int64_t t1_us;
+    int64_t t2_us;
+    int64_t t3_us;
+    int state; // 0: idle, 1: SYNC received, 2: DELAY_REQ sent
+} s_pending;
+
+static sync_sample_t s_window[CLOCK_SYNC_WINDOW];
+static int s_window_len;
+static int s_window_next;
+
+static sync_sample_t s_best;   // sample the offset is taken from
+static sync_sample_t s_anchor; // earlier best sample the drift is measured against
+static int s_drift_valid;
+static clock_sync_status_t s_status;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void add_sample(const sync_sample_t *sample)
+{
+    s_window[s_window_next] = *sample;
+    s_window_next = (s_window_next + 1) % CLOCK_SYNC_WINDOW;
+    if (s_window_len < CLOCK_SYNC_WINDOW)
+    {
+        s_window_len++;
+    }
+
+    // lowest round trip among the samples that are recent enough, the new one always is
+    const sync_sample_t *best = sample;
+    for (int i = 0; i < s_window_len; i++)
+    {
+        if (s_window[i].local_us >= sample->local_us - CLOCK_SYNC_MAX_AGE_US && s_window[i].delay_us < best->delay_us)
+        {
+            best = &s_window[i];
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (!s_status.valid)
+    {
+        s_anchor = *best;
+    }
+    else if (best->local_us - s_anchor.local_us >= CLOCK_SYNC_DRIFT_MIN_SPAN_US)
+    {
+        double drift_ppm = (double)(best->offset_us - s_anchor.offset_us) * 1e6 / (best->local_us - s_anchor.local_us);
+        if (drift_ppm > -CLOCK_SYNC_MAX_DRIFT_PPM && drift_ppm < CLOCK_SYNC_MAX_DRIFT_PPM)
+        {
+            // smooth it, a single sample pair is noisy over short spans
+            s_status.drift_ppm = s_drift_valid ? s_status.drift_ppm + (drift_ppm - s_status.drift_ppm) / 4 : drift_ppm;
+            s_drift_valid = 1;
+        }
+        s_anchor = *best;
+    }
+    s_best = *best;
+    s_status.valid = 1;
+    s_status.offset_us = best->offset_us;
+    s_status.delay_us = best->delay_us;
+    s_status.samples++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void clock_sync_on_sync(uint32_t seq, int64_t t1_us, int64_t t2_us)
+{
+    s_pending.seq = seq;
+    s_pending.t1_us = t1_us;
+    s_pending.t2_us = t2_us;
+    s_pending.state = 1;
+}
+
+void clock_sync_on_delay_req(uint32_t seq, int64_t t3_us)
+{
+    if (s_pending.state == 1 && s_pending.seq == seq)
+    {
+        s_pending.t3_us = t3_us;
+        s_pending.state = 2;
+    }
+}
+
+void clock_sync_on_delay_resp(uint32_t seq, int64_t t4_us)
+{
+    if (s_pending.state != 2 || s_pending.seq != seq)
+    {
+        return; // late or duplicate answer
+    }
+    s_pending.state = 0;
+
+    sync_sample_t sample = {
+        .local_us = s_pending.t2_us,
+        .offset_us = ((s_pending.t2_us - s_pending.t1_us) + (s_pending.t3_us - t4_us)) / 2,
+        .delay_us = (s_pending.t2_us - s_pending.t1_us) + (t4_us - s_pending.t3_us),
+    };
+    if (sample.delay_us < 0)
+    {
+        return; // timestamps out of order, can't be a real exchange
+    }
+    add_sample(&sample);
+}
+
+// Offset at local time local_us, extrapolated from the best sample with the drift
+static int64_t offset_at(int64_t local_us)
+{
+    return s_best.offset_us + (int64_t)(s_status.drift_ppm * (local_us - s_best.local_us) / 1e6);
+}
+
+int64_t clock_sync_to_server_us(int64_t local_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t server_us = s_status.valid ? local_us - offset_at(local_us) : local_us;
+    portEXIT_CRITICAL(&s_lock);
+    return server_us;
+}
+
+int64_t clock_sync_to_local_us(int64_t server_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t local_us = server_us;
+    if (s_status.valid)
+    {
+        // the drift term depends on the local time itself, one step is close enough at sane drifts
+        local_us = server_us + offset_at(server_us + s_best.offset_us);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return local_us;
+}
+
+void clock_sync_get_status(clock_sync_status_t *status)
+{
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
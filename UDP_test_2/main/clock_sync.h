@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Estimate of the server (time master) clock on top of esp_timer_get_time().
+//
+// The server broadcasts SYNC(t1) frames; a device notes the local receive time t2, answers with
+// DELAY_REQ sent at local time t3, and the server returns its receive time t4 in DELAY_RESP:
+//
+//   offset = ((t2 - t1) + (t3 - t4)) / 2   local clock minus server clock
+//   delay  =  (t2 - t1) + (t4 - t3)        round trip, without the time spent on the device
+//
+// The sample with the lowest round trip out of the recent ones gives the offset, as it was the least
+// disturbed by queuing delays; the drift between both clocks is estimated from best samples taken
+// at least CLOCK_SYNC_DRIFT_MIN_SPAN_US apart.
+
+typedef struct
+{
+    int valid;         // 1 once a sample has been taken
+    int64_t offset_us; // local minus server clock, at the time of the best sample
+    int64_t delay_us;  // round trip of the best sample
+    double drift_ppm;  // how much faster the local clock runs, in parts per million
+    uint32_t samples;  // samples taken since boot
+} clock_sync_status_t;
+
+// A SYNC frame with server send time t1 arrived at local time t2
+void clock_sync_on_sync(uint32_t seq, int64_t t1_us, int64_t t2_us);
+
+// The DELAY_REQ answering SYNC seq is being sent at local time t3
+void clock_sync_on_delay_req(uint32_t seq, int64_t t3_us);
+
+// The DELAY_RESP for seq arrived with the server receive time t4, completing a sample
+void clock_sync_on_delay_resp(uint32_t seq, int64_t t4_us);
+
+// Convert between the local and the server clock. Without any sample, the clocks are taken as equal
+int64_t clock_sync_to_server_us(int64_t local_us);
+int64_t clock_sync_to_local_us(int64_t server_us);
+
+void clock_sync_get_status(clock_sync_status_t *status);
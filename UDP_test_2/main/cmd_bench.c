@@ -0,0 +1,118 @@
+#include "cmd_bench.h"
+#include "cmd_proto.h"
+#include "cmd_json.h"
+
+#include "esp_timer.h" // esp_timer_get_time
+#include "cJSON.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_ITERATIONS 10000
+
+static const char s_json_start[] = "{\"cmd\": \"start\", \"seq\": 1, \"delay_ms\": 9950, \"session\": 42}";
+
+static volatile uint32_t s_sink; // keeps the compiler from dropping the benchmarked work
+
+static void print_result(const char *what, int64_t elapsed_us, size_t size)
+{
+    printf("%-30s %8.0f ns/op %10.0f ops/s %5u bytes\n", what, elapsed_us * 1000.0 / BENCH_ITERATIONS,
+           BENCH_ITERATIONS * 1e6 / (elapsed_us ? elapsed_us : 1), (unsigned)size);
+}
+
+// Decode a start command with cJSON, the way a full JSON parse on the device would
+static void bench_json_decode(void)
+{
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        cJSON *root = cJSON_Parse(s_json_start);
+        if (root == NULL)
+        {
+            printf("cJSON_Parse failed\n");
+            return;
+        }
+        cmd_msg_t msg = {0};
+        const cJSON *item = cJSON_GetObjectItem(root, "cmd");
+        msg.cmd = cJSON_IsString(item) && strcmp(item->valuestring, "start") == 0 ? CMD_PROTO_CMD_START : 0;
+        msg.seq = cJSON_GetObjectItem(root, "seq")->valueint;
+        msg.delay_ms = cJSON_GetObjectItem(root, "delay_ms")->valueint;
+        msg.session = cJSON_GetObjectItem(root, "session")->valueint;
+        cJSON_Delete(root);
+        s_sink += msg.cmd + msg.seq + msg.delay_ms + msg.session;
+    }
+    print_result("start decode, JSON (cJSON)", esp_timer_get_time() - start, strlen(s_json_start));
+}
+
+// Decode the same command with the zero-allocation parser
+static void bench_json_parse(void)
+{
+    size_t len = strlen(s_json_start);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        char name[CMD_JSON_NAME_MAX];
+        cmd_msg_t msg;
+        if (cmd_json_parse(s_json_start, len, name, sizeof(name), &msg) != 0)
+        {
+            printf("cmd_json_parse failed\n");
+            return;
+        }
+        s_sink += name[0] + msg.seq + msg.delay_ms + msg.session;
+    }
+    print_result("start decode, JSON (cmd_json)", esp_timer_get_time() - start, len);
+}
+
+static void bench_binary_decode(void)
+{
+    cmd_msg_t msg = {.version = CMD_PROTO_VERSION, .cmd = CMD_PROTO_CMD_START, .seq = 1, .session = 42, .delay_ms = 9950};
+    uint8_t frame[CMD_PROTO_FRAME_SIZE];
+    size_t size = cmd_proto_encode(&msg, frame, sizeof(frame));
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        cmd_proto_decode(frame, size, &msg);
+        s_sink += msg.cmd + msg.seq + msg.delay_ms + msg.session;
+    }
+    print_result("start decode, binary", esp_timer_get_time() - start, size);
+}
+
+static void bench_json_encode(void)
+{
+    cmd_msg_t msg = {.version = CMD_PROTO_VERSION, .cmd = CMD_PROTO_CMD_START, .seq = 1, .session = 42};
+    char ack_msg[CMD_JSON_ACK_MAX];
+    int len = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        len = cmd_json_format_ack(ack_msg, sizeof(ack_msg), "ESP32_A", &msg);
+        s_sink += ack_msg[len / 2];
+    }
+    print_result("ack encode, JSON (snprintf)", esp_timer_get_time() - start, len);
+}
+
+static void bench_binary_encode(void)
+{
+    cmd_msg_t ack = {.version = CMD_PROTO_VERSION, .cmd = CMD_PROTO_CMD_ACK, .seq = 1, .session = 42, .device_id = "ESP32_A"};
+    uint8_t frame[CMD_PROTO_FRAME_SIZE];
+    size_t size = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        ack.timestamp_us = i;
+        size = cmd_proto_encode(&ack, frame, sizeof(frame));
+        s_sink += frame[size - 1];
+    }
+    print_result("ack encode, binary", esp_timer_get_time() - start, size);
+}
+
+void cmd_bench_run(void)
+{
+    printf("Command codec benchmark, %d iterations each\n", BENCH_ITERATIONS);
+    bench_json_decode();
+    bench_json_parse();
+    bench_binary_decode();
+    bench_json_encode();
+    bench_binary_encode();
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Time the command encoders/decoders and print the results, enabled by UDP_CMD_BENCHMARK
+void cmd_bench_run(void);
@@ -0,0 +1,33 @@
+#include "cmd_dedup.h"
+
+int cmd_dedup_check(cmd_dedup_t *dedup, const cmd_msg_t *msg)
+{
+    for (int i = 0; i < dedup->len; i++)
+    {
+        if (dedup->seen[i].cmd == msg->cmd && dedup->seen[i].session == msg->session && dedup->seen[i].seq == msg->seq)
+        {
+            return 1;
+        }
+    }
+    dedup->seen[dedup->next].cmd = msg->cmd;
+    dedup->seen[dedup->next].session = msg->session;
+    dedup->seen[dedup->next].seq = msg->seq;
+    dedup->next = (dedup->next + 1) % CMD_DEDUP_SLOTS;
+    if (dedup->len < CMD_DEDUP_SLOTS)
+    {
+        dedup->len++;
+    }
+    return 0;
+}
+
+int cmd_dedup_start_ignored(const cmd_dedup_start_t *pending, const cmd_dedup_start_t *fired, uint32_t session,
+                            uint32_t seq, int64_t target_us)
+{
+    if (pending->valid && pending->session == session && seq <= pending->seq)
+    {
+        return 1; // a retransmit of what's pending
+    }
+    int64_t since_fired = target_us - fired->target_us;
+    return fired->valid && fired->session == session && since_fired > -CMD_DEDUP_SAME_START_US &&
+           since_fired < CMD_DEDUP_SAME_START_US; // the session already started
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include "cmd_proto.h"
+
+// Retransmit rules of the start/stop commands, shared by the command service, the deadline
+// scheduler and the fleet simulator (sim/), so the simulated devices answer like real ones.
+//
+// A device remembers the last CMD_DEDUP_SLOTS commands it processed by (cmd, session, seq): a
+// retransmit whose ACK got lost is ACKed again but not processed twice. The cmd is part of the key,
+// so a stop reusing the seq of its start isn't taken for a duplicate.
+//
+// A start that isn't a duplicate can still be one the device has armed or fired already, sent again
+// with a higher seq; cmd_dedup_start_ignored() decides whether it replaces the pending one.
+
+#define CMD_DEDUP_SLOTS 8 // recent start/stop commands remembered to spot retransmits
+#define CMD_DEDUP_SAME_START_US 1000000 // a start this close to one that fired is a late retransmit of it
+
+typedef struct
+{
+    struct
+    {
+        uint8_t cmd;
+        uint32_t session;
+        uint32_t seq;
+    } seen[CMD_DEDUP_SLOTS];
+    int len;
+    int next;
+} cmd_dedup_t;
+
+// A pending or fired session start, as far as the supersede rule needs it
+typedef struct
+{
+    int valid;
+    uint32_t session;
+    uint32_t seq;
+    int64_t target_us;
+} cmd_dedup_start_t;
+
+// Returns 1 if msg was processed already. Otherwise it's remembered and 0 is returned
+int cmd_dedup_check(cmd_dedup_t *dedup, const cmd_msg_t *msg);
+
+// Returns 1 if a start of session with seq and target_us is to be ignored: an equal or lower seq of
+// the pending start's session, or the start that fired last, sent again for about the same time.
+// A higher seq moves the pending start, a different session replaces it
+int cmd_dedup_start_ignored(const cmd_dedup_start_t *pending, const cmd_dedup_start_t *fired, uint32_t session,
+                            uint32_t seq, int64_t target_us);
@@ -0,0 +1,344 @@
+#include "cmd_json.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CMD_JSON_KEY_MAX 16 // longer keys can't be known ones, they are skipped
+
+// Read position in the datagram, never past end
+typedef struct
+{
+    const char *p;
+    const char *end;
+} json_cursor_t;
+
+static void skip_ws(json_cursor_t *c)
+{
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\n' || *c->p == '\r'))
+    {
+        c->p++;
+    }
+}
+
+static int peek(const json_cursor_t *c)
+{
+    return c->p < c->end ? (unsigned char)*c->p : -1;
+}
+
+static int is_digit(int ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+static int hex_value(int ch)
+{
+    if (is_digit(ch))
+    {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f')
+    {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F')
+    {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+// Parse a string token and copy its decoded value into out, if out is not NULL.
+// A value that doesn't fit is cut short and *truncated is set. Only ASCII can be copied,
+// other \u escapes are accepted but make the copy fail.
+static int parse_string(json_cursor_t *c, char *out, size_t size, int *truncated)
+{
+    size_t n = 0;
+    *truncated = 0;
+    if (peek(c) != '"')
+    {
+        return -1;
+    }
+    c->p++;
+    while (c->p < c->end)
+    {
+        unsigned char ch = *c->p++;
+        if (ch == '"')
+        {
+            if (out)
+            {
+                out[n] = '\0';
+            }
+            return 0;
+        }
+        if (ch < 0x20)
+        {
+            return -1; // control characters must be escaped
+        }
+        if (ch == '\\')
+        {
+            if (c->p >= c->end)
+            {
+                return -1;
+            }
+            ch = *c->p++;
+            switch (ch)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                break;
+            case 'b':
+                ch = '\b';
+                break;
+            case 'f':
+                ch = '\f';
+                break;
+            case 'n':
+                ch = '\n';
+                break;
+            case 'r':
+                ch = '\r';
+                break;
+            case 't':
+                ch = '\t';
+                break;
+            case 'u':
+            {
+                uint32_t code = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    int digit = c->p < c->end ? hex_value((unsigned char)*c->p++) : -1;
+                    if (digit < 0)
+                    {
+                        return -1;
+                    }
+                    code = (code << 4) | digit;
+                }
+                if (out && (code == 0 || code >= 0x80))
+                {
+                    return -1;
+                }
+                ch = (unsigned char)code;
+                break;
+            }
+            default:
+                return -1;
+            }
+        }
+        if (out)
+        {
+            if (n + 1 < size)
+            {
+                out[n++] = ch;
+            }
+            else
+            {
+                *truncated = 1;
+            }
+        }
+    }
+    return -1; // unterminated
+}
+
+// Parse a number token. If value is not NULL, the number must also be an integer in 0..UINT32_MAX
+static int parse_number(json_cursor_t *c, uint32_t *value)
+{
+    int negative = 0;
+    int integer = 1;
+    uint64_t v = 0;
+
+    if (peek(c) == '-')
+    {
+        negative = 1;
+        c->p++;
+    }
+    if (!is_digit(peek(c)))
+    {
+        return -1;
+    }
+    if (peek(c) == '0')
+    {
+        c->p++; // no leading zeros
+    }
+    else
+    {
+        while (is_digit(peek(c)))
+        {
+            if (v <= UINT32_MAX)
+            {
+                v = v * 10 + (*c->p - '0'); // stops growing once it's out of range
+            }
+            c->p++;
+        }
+    }
+    if (peek(c) == '.')
+    {
+        integer = 0;
+        c->p++;
+        if (!is_digit(peek(c)))
+        {
+            return -1;
+        }
+        while (is_digit(peek(c)))
+        {
+            c->p++;
+        }
+    }
+    if (peek(c) == 'e' || peek(c) == 'E')
+    {
+        integer = 0;
+        c->p++;
+        if (peek(c) == '+' || peek(c) == '-')
+        {
+            c->p++;
+        }
+        if (!is_digit(peek(c)))
+        {
+            return -1;
+        }
+        while (is_digit(peek(c)))
+        {
+            c->p++;
+        }
+    }
+    if (value)
+    {
+        if (negative || !integer || v > UINT32_MAX)
+        {
+            return -1;
+        }
+        *value = (uint32_t)v;
+    }
+    return 0;
+}
+
+static int parse_literal(json_cursor_t *c, const char *literal)
+{
+    size_t len = strlen(literal);
+    if ((size_t)(c->end - c->p) < len || memcmp(c->p, literal, len) != 0)
+    {
+        return -1;
+    }
+    c->p += len;
+    return 0;
+}
+
+// Skip the value of an unknown key, nested objects and arrays are not part of the schema
+static int skip_value(json_cursor_t *c)
+{
+    int truncated;
+    switch (peek(c))
+    {
+    case '"':
+        return parse_string(c, NULL, 0, &truncated);
+    case 't':
+        return parse_literal(c, "true");
+    case 'f':
+        return parse_literal(c, "false");
+    case 'n':
+        return parse_literal(c, "null");
+    default:
+        return parse_number(c, NULL);
+    }
+}
+
+int cmd_json_parse(const char *buf, size_t len, char *name, size_t name_size, cmd_msg_t *msg)
+{
+    json_cursor_t c = {.p = buf, .end = buf + len};
+    int have_cmd = 0;
+    memset(msg, 0, sizeof(*msg));
+
+    skip_ws(&c);
+    if (peek(&c) != '{')
+    {
+        return -1;
+    }
+    c.p++;
+    skip_ws(&c);
+    if (peek(&c) == '}')
+    {
+        return -1; // empty object, no "cmd"
+    }
+
+    while (1)
+    {
+        char key[CMD_JSON_KEY_MAX];
+        int truncated;
+        if (parse_string(&c, key, sizeof(key), &truncated) != 0)
+        {
+            return -1;
+        }
+        skip_ws(&c);
+        if (peek(&c) != ':')
+        {
+            return -1;
+        }
+        c.p++;
+        skip_ws(&c);
+
+        int ret;
+        if (truncated)
+        {
+            ret = skip_value(&c);
+        }
+        else if (strcmp(key, "cmd") == 0)
+        {
+            ret = parse_string(&c, name, name_size, &truncated);
+            ret = (ret != 0 || truncated) ? -1 : 0;
+            have_cmd = 1;
+        }
+        else if (strcmp(key, "seq") == 0)
+        {
+            ret = parse_number(&c, &msg->seq);
+        }
+        else if (strcmp(key, "session") == 0)
+        {
+            ret = parse_number(&c, &msg->session);
+        }
+        else if (strcmp(key, "delay_ms") == 0)
+        {
+            ret = parse_number(&c, &msg->delay_ms);
+        }
+        else if (strcmp(key, "id") == 0)
+        {
+            ret = parse_string(&c, msg->device_id, sizeof(msg->device_id), &truncated);
+            ret = (ret != 0 || truncated) ? -1 : 0;
+        }
+        else
+        {
+            ret = skip_value(&c);
+        }
+        if (ret != 0)
+        {
+            return -1;
+        }
+
+        skip_ws(&c);
+        if (peek(&c) == ',')
+        {
+            c.p++;
+            skip_ws(&c);
+            continue;
+        }
+        if (peek(&c) == '}')
+        {
+            c.p++;
+            break;
+        }
+        return -1;
+    }
+
+    skip_ws(&c);
+    if (c.p != c.end)
+    {
+        return -1; // trailing garbage
+    }
+    return have_cmd ? 0 : -1;
+}
+
+int cmd_json_format_ack(char *buf, size_t size, const char *device_id, const cmd_msg_t *msg)
+{
+    return snprintf(buf, size, "{ \"id\": \"%s\", \"status\": \"ack\", \"session\": %lu, \"seq\": %lu }",
+                    device_id, (unsigned long)msg->session, (unsigned long)msg->seq);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include "cmd_proto.h"
+
+#define CMD_JSON_NAME_MAX 16 // longest "cmd" value, including the terminator
+#define CMD_JSON_ACK_MAX 96  // longest ACK, including the terminator
+
+// Parse a JSON command datagram, e.g. {"cmd": "start", "seq": 0, "delay_ms": 10000, "session": 42}
+//
+// Single pass over buf, nothing is allocated and buf is not modified or required to be zero terminated.
+// The value of "cmd" is copied into name; "seq", "session" and "delay_ms" (unsigned 32-bit integers)
+// and "id" go into msg, fields that are absent are left zero. Other keys are skipped, as long as their
+// values are strings, numbers, true, false or null.
+//
+// Returns 0 on success, -1 if buf is not a single well-formed object, "cmd" is missing or too long,
+// or a known field has the wrong type or range.
+int cmd_json_parse(const char *buf, size_t len, char *name, size_t name_size, cmd_msg_t *msg);
+
+// Write the JSON ACK of a start/stop, {"id": ..., "status": "ack", "session": ..., "seq": ...}, with
+// the session and seq of msg. Returns its length, like snprintf
+int cmd_json_format_ack(char *buf, size_t size, const char *device_id, const cmd_msg_t *msg);
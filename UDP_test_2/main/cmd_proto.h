@@ -0,0 +1,162 @@
+#pragma once
+
+// Binary wire format of the session commands, shared by the device and
+// server/server.py (which has the same layout as a struct format string).
+//
+// All fields are in network byte order:
+//
+//   offset  size  field
+//        0     2  magic, CMD_PROTO_MAGIC
+//        2     1  version, CMD_PROTO_VERSION of the sender
+//        3     1  cmd, one of cmd_proto_cmd_t
+//        4     4  seq
+//        8     4  session
+//       12     4  delay_ms
+//       16    12  device id, zero padded, not necessarily zero terminated
+//       28     8  timestamp_us, sender's clock when the frame was built
+//   version 2 and later:
+//       36     8  ref_us, a point in time on the server clock, meaning depends on cmd
+//
+// Version negotiation: later versions only append fields, so a receiver
+// decodes any version and ignores the bytes it doesn't know. A reply is sent
+// with the lower of the request's version and the receiver's own one, so the
+// requester learns which fields the peer understands.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CMD_PROTO_MAGIC 0x5544 // "UD"
+#define CMD_PROTO_VERSION 2
+#define CMD_PROTO_FRAME_SIZE_V1 36
+#define CMD_PROTO_FRAME_SIZE 44 // frame size of CMD_PROTO_VERSION, the largest one
+#define CMD_PROTO_ID_LEN 12
+
+typedef enum
+{
+    CMD_PROTO_CMD_START = 1,
+    CMD_PROTO_CMD_STOP = 2,
+    CMD_PROTO_CMD_ACK = 3,
+    // Clock synchronization, PTP style, the server is the time master:
+    CMD_PROTO_CMD_SYNC = 4,       // server -> all, timestamp_us: server send time (t1)
+    CMD_PROTO_CMD_DELAY_REQ = 5,  // device -> server, answers SYNC with the same seq, timestamp_us: device send time (t3)
+    CMD_PROTO_CMD_DELAY_RESP = 6, // server -> device, timestamp_us: server receive time of DELAY_REQ (t4)
+    CMD_PROTO_CMD_TIME_QUERY = 7, // server -> all, asks for the device's estimate of the server clock
+    CMD_PROTO_CMD_TIME_REPLY = 8, // device -> server, timestamp_us: server clock as estimated by the device
+    // Session start report, device -> server, seq of the start that armed it,
+    // timestamp_us: actual start time, ref_us: target start time, both on the server clock
+    CMD_PROTO_CMD_REPORT = 9,
+    // Device discovery, the server keeps a registry of the devices and the address they send from:
+    CMD_PROTO_CMD_ANNOUNCE = 10, // device -> server, at boot, periodically and in answer to DISCOVER, seq: announce count
+    CMD_PROTO_CMD_DISCOVER = 11, // server -> all, asks every device to announce itself to the sender
+    // Health report, device -> server, once per window, see telemetry.h for the payload that follows
+    // the frame. seq: report count, delay_ms: window length
+    CMD_PROTO_CMD_TELEMETRY = 12,
+} cmd_proto_cmd_t;
+
+// Decoded command, also filled in from JSON datagrams
+typedef struct
+{
+    uint8_t version;
+    uint8_t cmd; // cmd_proto_cmd_t
+    uint32_t seq;
+    uint32_t session;
+    uint32_t delay_ms;
+    char device_id[CMD_PROTO_ID_LEN + 1]; // always zero terminated
+    int64_t timestamp_us;
+    int64_t ref_us; // START: absolute start time on the server clock, 0 if only delay_ms applies; REPORT: target time
+} cmd_msg_t;
+
+static inline void cmd_proto_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static inline uint32_t cmd_proto_get_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// True if the datagram starts like a binary frame, JSON always starts with '{' or whitespace
+static inline int cmd_proto_is_frame(const uint8_t *buf, size_t len)
+{
+    return len >= 2 && buf[0] == (CMD_PROTO_MAGIC >> 8) && buf[1] == (CMD_PROTO_MAGIC & 0xFF);
+}
+
+static inline void cmd_proto_put_i64(uint8_t *p, int64_t v)
+{
+    cmd_proto_put_u32(p, (uint64_t)v >> 32);
+    cmd_proto_put_u32(p + 4, (uint32_t)v);
+}
+
+static inline int64_t cmd_proto_get_i64(const uint8_t *p)
+{
+    return (int64_t)(((uint64_t)cmd_proto_get_u32(p) << 32) | cmd_proto_get_u32(p + 4));
+}
+
+// Encode msg into buf, in the layout of msg->version. Returns the frame size, or 0 if buf is too small
+static inline size_t cmd_proto_encode(const cmd_msg_t *msg, uint8_t *buf, size_t size)
+{
+    size_t frame_size = msg->version >= 2 ? CMD_PROTO_FRAME_SIZE : CMD_PROTO_FRAME_SIZE_V1;
+    if (size < frame_size)
+    {
+        return 0;
+    }
+    buf[0] = CMD_PROTO_MAGIC >> 8;
+    buf[1] = CMD_PROTO_MAGIC & 0xFF;
+    buf[2] = msg->version;
+    buf[3] = msg->cmd;
+    cmd_proto_put_u32(buf + 4, msg->seq);
+    cmd_proto_put_u32(buf + 8, msg->session);
+    cmd_proto_put_u32(buf + 12, msg->delay_ms);
+    memset(buf + 16, 0, CMD_PROTO_ID_LEN);
+    memcpy(buf + 16, msg->device_id, strnlen(msg->device_id, CMD_PROTO_ID_LEN));
+    cmd_proto_put_i64(buf + 28, msg->timestamp_us);
+    if (msg->version >= 2)
+    {
+        cmd_proto_put_i64(buf + 36, msg->ref_us);
+    }
+    return frame_size;
+}
+
+// Decode a frame of any version. Returns 0 on success, -1 if it isn't a valid frame
+static inline int cmd_proto_decode(const uint8_t *buf, size_t len, cmd_msg_t *msg)
+{
+    if (len < CMD_PROTO_FRAME_SIZE_V1 || !cmd_proto_is_frame(buf, len) || buf[2] == 0 ||
+        (buf[2] >= 2 && len < CMD_PROTO_FRAME_SIZE))
+    {
+        return -1;
+    }
+    msg->version = buf[2];
+    msg->cmd = buf[3];
+    msg->seq = cmd_proto_get_u32(buf + 4);
+    msg->session = cmd_proto_get_u32(buf + 8);
+    msg->delay_ms = cmd_proto_get_u32(buf + 12);
+    memcpy(msg->device_id, buf + 16, CMD_PROTO_ID_LEN);
+    msg->device_id[CMD_PROTO_ID_LEN] = '\0';
+    msg->timestamp_us = cmd_proto_get_i64(buf + 28);
+    msg->ref_us = buf[2] >= 2 ? cmd_proto_get_i64(buf + 36) : 0;
+    return 0;
+}
+
+// Version to answer a request with
+static inline uint8_t cmd_proto_reply_version(uint8_t request_version)
+{
+    return request_version < CMD_PROTO_VERSION ? request_version : CMD_PROTO_VERSION;
+}
+
+// Reply of type cmd to a binary request: the request's session and seq, in its reply version.
+// The sender fills in its device id and, unless it's stamped at send time, the timestamp
+static inline cmd_msg_t cmd_proto_reply(const cmd_msg_t *request, uint8_t cmd)
+{
+    cmd_msg_t reply = {
+        .version = cmd_proto_reply_version(request->version),
+        .cmd = cmd,
+        .seq = request->seq,
+        .session = request->session,
+    };
+    return reply;
+}
@@ -0,0 +1,601 @@
+#include "cmd_service.h"
+#include "cmd_json.h"
+#include "cmd_dedup.h"
+#include "clock_sync.h"
+#include "deadline_sched.h"
+#include "boot_timeline.h"
+#include "telemetry.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h" // esp_timer_get_time
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CMD_RX_BUFFER_SIZE 256
+#define CMD_RX_PRIORITY 6     // above the worker, a burst is taken off the socket before it's handled
+#define CMD_WORKER_PRIORITY 5
+#define CMD_UNKNOWN_LOG_US 1000000 // unknown datagrams are logged by the worker, at most this often
+
+// The receive task runs on the core of the lwIP task (or the Wi-Fi task, if lwIP isn't pinned), so a
+// datagram is taken off the socket without a core switch. The handlers run on the other core
+#if CONFIG_FREERTOS_UNICORE || CONFIG_IDF_TARGET_LINUX
+#define CMD_RX_CORE tskNO_AFFINITY
+#define CMD_WORKER_CORE tskNO_AFFINITY
+#elif CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU1 || (!CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU0 && CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1)
+#define CMD_RX_CORE 1
+#define CMD_WORKER_CORE 0
+#else
+#define CMD_RX_CORE 0
+#define CMD_WORKER_CORE 1
+#endif
+
+// A classified command, handed from the receive task to the worker by copy
+typedef struct
+{
+    uint8_t handler; // index into s_handlers
+    uint8_t binary;
+    int len;
+    cmd_msg_t msg;
+    struct sockaddr_in source;
+    int64_t rx_time_us;
+    char payload[CMD_RX_BUFFER_SIZE]; // the datagram, zero terminated
+} cmd_work_t;
+
+static cmd_service_config_t s_config;
+static int s_sock = -1;
+static QueueHandle_t s_queue; // cmd_work_t, receive task -> worker
+static struct sockaddr_in s_announce_addr;
+static struct sockaddr_in s_report_addr; // sender of the start that armed the pending session
+static portMUX_TYPE s_report_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_announce_seq;
+static cmd_service_stats_t s_stats = {.latency_min_us = UINT32_MAX};
+static struct
+{
+    uint8_t binary;
+    uint8_t cmd;
+    int len;
+} s_last_unknown; // under s_stats_lock, like the unknown count
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static cmd_dedup_t s_seen; // recently processed commands, only touched by the worker task
+
+static void handle_start(const cmd_request_t *req);
+static void handle_stop(const cmd_request_t *req);
+static void handle_stats(const cmd_request_t *req);
+static void handle_sync(const cmd_request_t *req);
+static void handle_delay_resp(const cmd_request_t *req);
+static void handle_time_query(const cmd_request_t *req);
+static void handle_discover(const cmd_request_t *req);
+static void handle_boot(const cmd_request_t *req);
+
+// Dispatch table, looked up by the "cmd" field of a JSON datagram or the cmd byte of a binary frame
+static const struct
+{
+    const char *name; // NULL if the command is binary only, its reply is a frame of CMD_PROTO_VERSION
+    uint8_t cmd;      // cmd_proto_cmd_t, 0 if the command is JSON only
+    cmd_handler_t handler;
+} s_handlers[] = {
+    {"start", CMD_PROTO_CMD_START, handle_start},
+    {"stop", CMD_PROTO_CMD_STOP, handle_stop},
+    {"stats", 0, handle_stats},
+    {NULL, CMD_PROTO_CMD_SYNC, handle_sync},
+    {NULL, CMD_PROTO_CMD_DELAY_RESP, handle_delay_resp},
+    {NULL, CMD_PROTO_CMD_TIME_QUERY, handle_time_query},
+    {NULL, CMD_PROTO_CMD_DISCOVER, handle_discover},
+    {"boot", 0, handle_boot},
+};
+
+static void record_latency(uint32_t latency_us)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.dispatched++;
+    s_stats.latency_sum_us += latency_us;
+    if (latency_us < s_stats.latency_min_us)
+    {
+        s_stats.latency_min_us = latency_us;
+    }
+    if (latency_us > s_stats.latency_max_us)
+    {
+        s_stats.latency_max_us = latency_us;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+    telemetry_record_latency(latency_us);
+}
+
+static void print_request(const char *what, const cmd_request_t *req)
+{
+    if (req->binary)
+    {
+        printf("%s received: v%u session %lu seq %lu delay_ms %lu\n", what, req->msg.version,
+               (unsigned long)req->msg.session, (unsigned long)req->msg.seq, (unsigned long)req->msg.delay_ms);
+    }
+    else
+    {
+        printf("%s received: %s\n", what, req->payload);
+    }
+}
+
+// Returns 1 if the command was processed already, a retransmit whose ACK got lost, see cmd_dedup.h
+static int check_seen(const cmd_msg_t *msg)
+{
+    if (!cmd_dedup_check(&s_seen, msg))
+    {
+        return 0;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.duplicates++;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return 1;
+}
+
+// Send msg as a binary frame of the given version, with our device id.
+// Unless msg carries a timestamp already, it's stamped right before it's sent
+static void send_frame(uint8_t version, cmd_msg_t *msg, const struct sockaddr_in *dest)
+{
+    msg->version = version;
+    strncpy(msg->device_id, s_config.device_id, CMD_PROTO_ID_LEN);
+    uint8_t frame[CMD_PROTO_FRAME_SIZE];
+    if (msg->timestamp_us == 0)
+    {
+        msg->timestamp_us = esp_timer_get_time();
+    }
+    size_t len = cmd_proto_encode(msg, frame, sizeof(frame));
+    sendto(s_sock, frame, len, 0, (const struct sockaddr *)dest, sizeof(*dest));
+}
+
+// Answer a binary request with a reply built by cmd_proto_reply(), in the request's version
+static void send_reply(cmd_msg_t *reply, const struct sockaddr_in *dest)
+{
+    send_frame(reply->version, reply, dest);
+}
+
+// ACK a start/stop to its sender with our id and the session and seq it carried, in the request's format
+static void send_ack(const cmd_request_t *req)
+{
+    if (req->binary)
+    {
+        cmd_msg_t ack = cmd_proto_reply(&req->msg, CMD_PROTO_CMD_ACK);
+        send_reply(&ack, &req->source);
+    }
+    else
+    {
+        char ack_msg[CMD_JSON_ACK_MAX];
+        int len = cmd_json_format_ack(ack_msg, sizeof(ack_msg), s_config.device_id, &req->msg);
+        sendto(req->sock, ack_msg, len, 0, (const struct sockaddr *)&req->source, sizeof(req->source));
+    }
+}
+
+static void handle_start(const cmd_request_t *req)
+{
+    if (check_seen(&req->msg))
+    {
+        send_ack(req); // the server is still waiting for it
+        return;
+    }
+    print_request("Start", req);
+
+    int64_t start_us;
+    clock_sync_status_t sync;
+    clock_sync_get_status(&sync);
+    if (req->msg.ref_us != 0 && sync.valid)
+    {
+        // absolute session time on the server clock, same instant on every synchronized device
+        start_us = clock_sync_to_local_us(req->msg.ref_us);
+    }
+    else
+    {
+        // no ref_us, or no sync sample yet to map it onto the local clock: the relative delay is
+        // the best estimate, the server clock's epoch is unrelated to esp_timer's
+        start_us = req->rx_time_us + (int64_t)req->msg.delay_ms * 1000;
+    }
+    portENTER_CRITICAL(&s_report_lock);
+    s_report_addr = req->source; // the start report goes back to whoever started the session
+    portEXIT_CRITICAL(&s_report_lock);
+    int ret = deadline_sched_arm(req->msg.session, req->msg.seq, start_us);
+    if (ret == 0)
+    {
+        printf("Session %lu starts in %lld us\n", (unsigned long)req->msg.session, (long long)(start_us - req->rx_time_us));
+    }
+    else if (ret < 0)
+    {
+        printf("Failed to schedule session %lu\n", (unsigned long)req->msg.session);
+    }
+
+    send_ack(req);
+}
+
+// SYNC from the time master: note both timestamps and answer with a DELAY_REQ right away
+static void handle_sync(const cmd_request_t *req)
+{
+    clock_sync_on_sync(req->msg.seq, req->msg.timestamp_us, req->rx_time_us);
+
+    cmd_msg_t delay_req = cmd_proto_reply(&req->msg, CMD_PROTO_CMD_DELAY_REQ);
+    send_reply(&delay_req, &req->source);
+    clock_sync_on_delay_req(req->msg.seq, delay_req.timestamp_us);
+}
+
+static void handle_delay_resp(const cmd_request_t *req)
+{
+    if (strcmp(req->msg.device_id, s_config.device_id) == 0)
+    {
+        clock_sync_on_delay_resp(req->msg.seq, req->msg.timestamp_us);
+    }
+}
+
+// Report the server time as estimated at reception, the server compares it with its own clock
+static void handle_time_query(const cmd_request_t *req)
+{
+    cmd_msg_t reply = cmd_proto_reply(&req->msg, CMD_PROTO_CMD_TIME_REPLY);
+    reply.timestamp_us = clock_sync_to_server_us(req->rx_time_us);
+    send_reply(&reply, &req->source);
+}
+
+// Tell dest our id; the server registers the address the frame came from
+static void send_announce(const struct sockaddr_in *dest)
+{
+    cmd_msg_t announce = {
+        .cmd = CMD_PROTO_CMD_ANNOUNCE,
+        .seq = s_announce_seq++, // 0 tells the server the device just booted
+    };
+    send_frame(CMD_PROTO_VERSION, &announce, dest);
+}
+
+static void handle_discover(const cmd_request_t *req)
+{
+    send_announce(&req->source);
+}
+
+static void handle_stop(const cmd_request_t *req)
+{
+    if (!check_seen(&req->msg))
+    {
+        print_request("Stop", req);
+        if (deadline_sched_cancel(req->msg.session) == 0)
+        {
+            printf("Session %lu cancelled\n", (unsigned long)req->msg.session);
+        }
+    }
+    send_ack(req);
+}
+
+// Deadline task: the session starts now. Report the fire time and the target on the server clock,
+// their difference is the scheduling jitter
+static void on_session_start(const deadline_event_t *event)
+{
+    cmd_msg_t report = {
+        .cmd = CMD_PROTO_CMD_REPORT,
+        .seq = event->seq,
+        .session = event->session,
+        .timestamp_us = clock_sync_to_server_us(event->fired_us),
+        .ref_us = clock_sync_to_server_us(event->target_us),
+    };
+    portENTER_CRITICAL(&s_report_lock);
+    struct sockaddr_in dest = s_report_addr;
+    portEXIT_CRITICAL(&s_report_lock);
+    send_frame(CMD_PROTO_VERSION, &report, &dest);
+    printf("Session %lu started, %lld us after the target\n", (unsigned long)event->session,
+           (long long)(event->fired_us - event->target_us));
+}
+
+// Reply to the sender with the latency counters
+static void handle_stats(const cmd_request_t *req)
+{
+    cmd_service_stats_t stats;
+    cmd_service_get_stats(&stats);
+    clock_sync_status_t sync;
+    clock_sync_get_status(&sync);
+
+    char reply[384];
+    int len = snprintf(reply, sizeof(reply),
+                       "{\"id\":\"%s\",\"packets\":%lu,\"dispatched\":%lu,\"unknown\":%lu,\"duplicates\":%lu,"
+                       "\"dropped\":%lu,\"queue_max\":%lu,"
+                       "\"lat_min_us\":%lu,\"lat_avg_us\":%lu,\"lat_max_us\":%lu,"
+                       "\"sync_offset_us\":%lld,\"sync_delay_us\":%lld,\"drift_ppm\":%.2f}",
+                       s_config.device_id, (unsigned long)stats.packets, (unsigned long)stats.dispatched,
+                       (unsigned long)stats.unknown, (unsigned long)stats.duplicates,
+                       (unsigned long)stats.dropped, (unsigned long)stats.queue_max,
+                       (unsigned long)(stats.dispatched ? stats.latency_min_us : 0),
+                       (unsigned long)(stats.dispatched ? stats.latency_sum_us / stats.dispatched : 0),
+                       (unsigned long)stats.latency_max_us,
+                       (long long)sync.offset_us, (long long)sync.delay_us, sync.drift_ppm);
+    sendto(req->sock, reply, len, 0, (const struct sockaddr *)&req->source, sizeof(req->source));
+}
+
+static void send_boot_timeline(const struct sockaddr_in *dest)
+{
+    char telemetry[384];
+    size_t len = boot_timeline_format_json(s_config.device_id, telemetry, sizeof(telemetry));
+    if (len > 0)
+    {
+        sendto(s_sock, telemetry, len, 0, (const struct sockaddr *)dest, sizeof(*dest));
+    }
+}
+
+// Reply to the sender with the boot timeline
+static void handle_boot(const cmd_request_t *req)
+{
+    send_boot_timeline(&req->source);
+}
+
+// Find the handler of a received datagram and decode it into req. Returns the handler's index in
+// s_handlers, or -1 if there is none
+static int classify(cmd_request_t *req)
+{
+    char name[CMD_JSON_NAME_MAX];
+    if (cmd_proto_is_frame((const uint8_t *)req->payload, req->len))
+    {
+        req->binary = 1;
+        if (cmd_proto_decode((const uint8_t *)req->payload, req->len, &req->msg) != 0)
+        {
+            req->msg.cmd = 0; // truncated frame, nothing matches
+        }
+    }
+    else if (cmd_json_parse(req->payload, req->len, name, sizeof(name), &req->msg) != 0)
+    {
+        name[0] = '\0'; // malformed JSON, nothing matches
+    }
+
+    for (size_t i = 0; i < sizeof(s_handlers) / sizeof(s_handlers[0]); i++)
+    {
+        if (req->binary ? (req->msg.cmd != 0 && req->msg.cmd == s_handlers[i].cmd)
+                        : (s_handlers[i].name != NULL && strcmp(name, s_handlers[i].name) == 0))
+        {
+            req->msg.cmd = s_handlers[i].cmd;
+            return (int)i;
+        }
+    }
+    // only counted, a flood of them mustn't hold up the receive task on the console, see log_unknown()
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.unknown++;
+    s_last_unknown.binary = req->binary;
+    s_last_unknown.cmd = req->msg.cmd;
+    s_last_unknown.len = req->len;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return -1;
+}
+
+// Worker task: print how many datagrams had no handler since *logged of them were printed
+static void log_unknown(uint32_t *logged)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    uint32_t unknown = s_stats.unknown;
+    int binary = s_last_unknown.binary;
+    unsigned cmd = s_last_unknown.cmd;
+    int len = s_last_unknown.len;
+    portEXIT_CRITICAL(&s_stats_lock);
+    if (unknown == *logged)
+    {
+        return;
+    }
+    if (binary)
+    {
+        printf("%lu unknown datagrams, the last one binary command %u, %d bytes\n", (unsigned long)(unknown - *logged),
+               cmd, len);
+    }
+    else
+    {
+        printf("%lu unknown datagrams, the last one malformed JSON or an unknown command, %d bytes\n",
+               (unsigned long)(unknown - *logged), len);
+    }
+    *logged = unknown;
+}
+
+// Receive task, next to the lwIP and Wi-Fi tasks: take a datagram off the socket, classify it and
+// queue it for the worker. It never blocks on anything but the socket, a full queue drops the command
+static void cmd_rx_task(void *arg)
+{
+    int sock = (int)(intptr_t)arg;
+    cmd_work_t work;
+
+    while (1)
+    {
+        socklen_t socklen = sizeof(work.source);
+        int len = recvfrom(sock, work.payload, sizeof(work.payload) - 1, 0, (struct sockaddr *)&work.source, &socklen);
+        if (len < 0)
+        {
+            if (errno != EINTR)
+            {
+                perror("recvfrom failed");
+                vTaskDelay(pdMS_TO_TICKS(CONFIG_UDP_CMD_POLL_TIMEOUT_MS));
+            }
+            continue;
+        }
+        int64_t rx_time_us = esp_timer_get_time();
+        work.payload[len] = 0; // Null-terminate string for safety
+
+        cmd_request_t req = {
+            .sock = sock,
+            .payload = work.payload,
+            .len = len,
+            .source = work.source,
+            .rx_time_us = rx_time_us,
+        };
+        int handler = classify(&req);
+
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.packets++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        if (handler < 0)
+        {
+            continue;
+        }
+        work.handler = handler;
+        work.binary = req.binary;
+        work.msg = req.msg;
+        work.len = len;
+        work.rx_time_us = rx_time_us;
+
+        int sent = xQueueSend(s_queue, &work, 0) == pdPASS;
+        uint32_t depth = uxQueueMessagesWaiting(s_queue);
+        portENTER_CRITICAL(&s_stats_lock);
+        if (!sent)
+        {
+            s_stats.dropped++;
+        }
+        if (depth > s_stats.queue_max)
+        {
+            s_stats.queue_max = depth;
+        }
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+}
+
+// Worker task, on the other core: run the handlers, they send the replies. It also does the periodic
+// announcements, so every send but the start report comes from here
+static void cmd_worker_task(void *arg)
+{
+    int sock = (int)(intptr_t)arg;
+    cmd_work_t work;
+    uint8_t report[CMD_PROTO_FRAME_SIZE + TELEMETRY_PAYLOAD_SIZE];
+
+    send_announce(&s_announce_addr);
+    send_boot_timeline(&s_announce_addr); // boot is over once the service runs
+    int64_t next_announce_us = esp_timer_get_time() + (int64_t)s_config.announce_interval_s * 1000000;
+    int64_t next_unknown_log_us = 0;
+    uint32_t unknown_logged = 0;
+
+    while (1)
+    {
+        if (esp_timer_get_time() >= next_unknown_log_us)
+        {
+            log_unknown(&unknown_logged);
+            next_unknown_log_us = esp_timer_get_time() + CMD_UNKNOWN_LOG_US;
+        }
+        if (s_config.announce_interval_s > 0 && esp_timer_get_time() >= next_announce_us)
+        {
+            send_announce(&s_announce_addr);
+            next_announce_us += (int64_t)s_config.announce_interval_s * 1000000;
+        }
+        size_t report_len = telemetry_poll(s_config.device_id, report, sizeof(report));
+        if (report_len > 0)
+        {
+            sendto(sock, report, report_len, 0, (const struct sockaddr *)&s_announce_addr, sizeof(s_announce_addr));
+        }
+
+        if (xQueueReceive(s_queue, &work, pdMS_TO_TICKS(CONFIG_UDP_CMD_POLL_TIMEOUT_MS)) != pdTRUE)
+        {
+            continue; // timeout, nothing to do yet
+        }
+        cmd_request_t req = {
+            .sock = sock,
+            .payload = work.payload,
+            .len = work.len,
+            .binary = work.binary,
+            .msg = work.msg,
+            .source = work.source,
+            .rx_time_us = work.rx_time_us,
+        };
+        record_latency((uint32_t)(esp_timer_get_time() - req.rx_time_us));
+        s_handlers[work.handler].handler(&req);
+    }
+}
+
+// Join the command multicast group on the default interface (IGMP). A failure isn't fatal,
+// broadcast and unicast commands still arrive
+static void join_multicast_group(int sock, const char *group)
+{
+    if (group == NULL || group[0] == '\0')
+    {
+        return;
+    }
+    struct ip_mreq mreq = {
+        .imr_interface.s_addr = htonl(INADDR_ANY),
+    };
+    if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1 || !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)))
+    {
+        printf("Invalid multicast group: %s\n", group);
+        return;
+    }
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+    {
+        perror("IP_ADD_MEMBERSHIP failed");
+        return;
+    }
+    printf("Joined multicast group %s\n", group);
+}
+
+int cmd_service_start(const cmd_service_config_t *config)
+{
+    s_config = *config;
+
+    s_announce_addr.sin_family = AF_INET;
+    s_announce_addr.sin_port = htons(config->announce_port);
+    if (inet_pton(AF_INET, config->announce_ip, &s_announce_addr.sin_addr) != 1)
+    {
+        printf("Invalid announce IP: %s\n", config->announce_ip);
+        return -1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP); // Create IPv4 UDP socket
+    if (sock < 0)
+    {
+        perror("socket failed");
+        return -1;
+    }
+    int broadcast = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast)) < 0)
+    {
+        perror("setsockopt failed");
+        close(sock);
+        return -1;
+    }
+
+    struct sockaddr_in listen_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(config->cmd_port),
+        .sin_addr.s_addr = htonl(INADDR_ANY), // Listen on any local IP
+    };
+    if (bind(sock, (struct sockaddr *)&listen_addr, sizeof(listen_addr)) < 0)
+    {
+        perror("bind failed");
+        close(sock);
+        return -1;
+    }
+    boot_timeline_mark(BOOT_PHASE_SOCKET_BOUND);
+    printf("Command service listening on port %u as %s\n", config->cmd_port, config->device_id);
+    join_multicast_group(sock, config->multicast_group);
+    s_sock = sock;
+
+    if (deadline_sched_init(on_session_start) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+    s_queue = xQueueCreate(CONFIG_UDP_CMD_QUEUE_LEN, sizeof(cmd_work_t));
+    if (s_queue == NULL)
+    {
+        printf("Failed to create command queue\n");
+        close(sock);
+        return -1;
+    }
+    telemetry_init(config->telemetry_interval_s * 1000);
+    TaskHandle_t worker_task = NULL;
+    TaskHandle_t rx_task = NULL;
+    if (xTaskCreatePinnedToCore(cmd_worker_task, "cmd_worker", 4096, (void *)(intptr_t)sock,
+                                CMD_WORKER_PRIORITY, &worker_task, CMD_WORKER_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(cmd_rx_task, "cmd_rx", 3072, (void *)(intptr_t)sock,
+                                CMD_RX_PRIORITY, &rx_task, CMD_RX_CORE) != pdPASS)
+    {
+        printf("Failed to create command service tasks\n");
+        close(sock);
+        return -1;
+    }
+    telemetry_watch_task(rx_task, "cmd_rx");
+    telemetry_watch_task(worker_task, "cmd_work");
+    telemetry_watch_task(deadline_sched_get_task(), "deadline");
+    return 0;
+}
+
+void cmd_service_get_stats(cmd_service_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <netinet/in.h> // sockaddr_in
+#include "cmd_proto.h"
+
+typedef struct
+{
+    uint16_t cmd_port;            // UDP port the commands arrive on
+    const char *multicast_group;  // group joined on cmd_port, NULL or "" for none
+    const char *announce_ip;      // where the device announces itself, a server or a broadcast address
+    uint16_t announce_port;       // server port the announcements are sent to
+    uint32_t announce_interval_s; // time between announcements, 0 to only announce at start and on request
+    uint32_t telemetry_interval_s; // telemetry window, reports go where the announcements go, 0 for none
+    const char *device_id;        // id reported in every reply
+} cmd_service_config_t;
+
+// One received datagram, as handed to a command handler
+typedef struct
+{
+    int sock;                  // service socket, for replies
+    const char *payload;       // null-terminated datagram
+    int len;                   // datagram length, without the terminator
+    int binary;                // 1 if it's a binary frame, replies are sent in the same format
+    cmd_msg_t msg;             // decoded command, from either format
+    struct sockaddr_in source; // sender of the datagram
+    int64_t rx_time_us;        // when recvfrom() returned it
+} cmd_request_t;
+
+typedef void (*cmd_handler_t)(const cmd_request_t *req);
+
+// Receive-to-handler latency counters, readable at any time
+typedef struct
+{
+    uint32_t packets;        // datagrams received
+    uint32_t dispatched;     // datagrams handed to a handler
+    uint32_t unknown;        // datagrams with no matching handler
+    uint32_t duplicates;     // start/stop commands seen before, ACKed again but not processed
+    uint32_t dropped;        // commands lost to a full queue between the receive task and the worker
+    uint32_t queue_max;      // most commands waiting for the worker at once
+    uint32_t latency_min_us; // receive to handler entry, including the wait in the queue
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+} cmd_service_stats_t;
+
+// Bind the command port and start the receive and worker tasks. Returns 0 on success
+int cmd_service_start(const cmd_service_config_t *config);
+
+// Copy the current latency counters
+void cmd_service_get_stats(cmd_service_stats_t *stats);
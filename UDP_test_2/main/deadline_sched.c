@@ -0,0 +1,148 @@
+#include "deadline_sched.h"
+#include "cmd_dedup.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+
+#define DEADLINE_TASK_PRIORITY (configMAX_PRIORITIES - 2) // above the esp_timer task
+#define DEADLINE_TASK_STACK 3072
+
+// The callback runs straight from the timer interrupt where that's supported, it's the lowest latency
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+#define DEADLINE_DISPATCH ESP_TIMER_ISR
+#else
+#define DEADLINE_DISPATCH ESP_TIMER_TASK
+#endif
+
+static esp_timer_handle_t s_timer;
+static TaskHandle_t s_task;
+static deadline_fire_cb_t s_on_fire;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static deadline_event_t s_pending; // valid while s_armed
+static int s_armed;
+static deadline_event_t s_fired; // last expired deadline, handed to the task
+static int s_fired_valid;
+
+static void IRAM_ATTR deadline_timer_cb(void *arg)
+{
+    int64_t now = esp_timer_get_time(); // first thing, it's what the jitter is measured on
+    int fire = 0;
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    // a callback that was already running while the deadline was re-armed sees a later target, skip it
+    if (s_armed && now >= s_pending.target_us)
+    {
+        s_fired = s_pending;
+        s_fired.fired_us = now;
+        s_fired_valid = 1;
+        s_armed = 0;
+        fire = 1;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    if (fire)
+    {
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+        BaseType_t task_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_task, &task_woken);
+        if (task_woken == pdTRUE)
+        {
+            // esp_timer yields once its ISR has run all the due callbacks, a yield from here would skip them
+            esp_timer_isr_dispatch_need_yield();
+        }
+#else
+        xTaskNotifyGive(s_task);
+#endif
+    }
+}
+
+static void deadline_task(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        portENTER_CRITICAL(&s_lock);
+        deadline_event_t event = s_fired;
+        portEXIT_CRITICAL(&s_lock);
+        s_on_fire(&event);
+    }
+}
+
+int deadline_sched_init(deadline_fire_cb_t on_fire)
+{
+    s_on_fire = on_fire;
+    if (xTaskCreate(deadline_task, "deadline", DEADLINE_TASK_STACK, NULL, DEADLINE_TASK_PRIORITY, &s_task) != pdPASS)
+    {
+        printf("Failed to create deadline task\n");
+        return -1;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = deadline_timer_cb,
+        .dispatch_method = DEADLINE_DISPATCH,
+        .name = "deadline",
+    };
+    if (esp_timer_create(&timer_args, &s_timer) != ESP_OK)
+    {
+        printf("Failed to create deadline timer\n");
+        return -1;
+    }
+    return 0;
+}
+
+int deadline_sched_arm(uint32_t session, uint32_t seq, int64_t target_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    const cmd_dedup_start_t pending = {s_armed, s_pending.session, s_pending.seq, s_pending.target_us};
+    const cmd_dedup_start_t fired = {s_fired_valid, s_fired.session, s_fired.seq, s_fired.target_us};
+    if (cmd_dedup_start_ignored(&pending, &fired, session, seq, target_us))
+    {
+        portEXIT_CRITICAL(&s_lock);
+        return 1; // a retransmit of what's pending, or the session already started
+    }
+    s_pending.session = session;
+    s_pending.seq = seq;
+    s_pending.target_us = target_us;
+    s_pending.fired_us = 0;
+    s_armed = 1;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_timer_stop(s_timer); // fails harmlessly if it isn't running
+    int64_t timeout = target_us - esp_timer_get_time();
+    if (esp_timer_start_once(s_timer, timeout > 0 ? timeout : 0) != ESP_OK)
+    {
+        portENTER_CRITICAL(&s_lock);
+        s_armed = 0;
+        portEXIT_CRITICAL(&s_lock);
+        return -1;
+    }
+    return 0;
+}
+
+int deadline_sched_cancel(uint32_t session)
+{
+    int cancelled = 0;
+    portENTER_CRITICAL(&s_lock);
+    if (s_armed && s_pending.session == session)
+    {
+        s_armed = 0;
+        cancelled = 1;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (cancelled)
+    {
+        esp_timer_stop(s_timer);
+    }
+    return cancelled ? 0 : 1;
+}
+
+TaskHandle_t deadline_sched_get_task(void)
+{
+    return s_task;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Microsecond deadline for the pending session start, on a one-shot esp_timer.
+//
+// The timer callback only takes the fire time and wakes a high-priority task, which runs the
+// fire callback. At CONFIG_FREERTOS_HZ=100 a vTaskDelay() based wait would be off by up to 10 ms;
+// this is off by the timer dispatch latency, reported as fired_us - target_us.
+//
+// One deadline is pending at a time. Arming it again for the same session only takes a higher seq
+// (a later retransmit of the same start), a different session replaces it, see cmd_dedup_start_ignored().
+
+typedef struct
+{
+    uint32_t session;
+    uint32_t seq;      // seq of the start command that armed the deadline
+    int64_t target_us; // local esp_timer time the deadline was set for
+    int64_t fired_us;  // local esp_timer time the timer callback ran
+} deadline_event_t;
+
+// Called from the deadline task when a deadline expires
+typedef void (*deadline_fire_cb_t)(const deadline_event_t *event);
+
+// Create the timer and the deadline task. Returns 0 on success
+int deadline_sched_init(deadline_fire_cb_t on_fire);
+
+// Arm the deadline at local time target_us. Returns 0 if armed, 1 if ignored because an equal
+// or higher seq of the same session is already pending, or the same start already fired, -1 on error
+int deadline_sched_arm(uint32_t session, uint32_t seq, int64_t target_us);
+
+// Cancel the pending deadline of session. Returns 0 if one was cancelled, 1 if there was none
+int deadline_sched_cancel(uint32_t session);
+
+// The deadline task, NULL before deadline_sched_init()
+TaskHandle_t deadline_sched_get_task(void);
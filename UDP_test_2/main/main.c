@@ -1,3 +1,17 @@
+#include "sdkconfig.h"
+#include "cmd_service.h"
+#include "cmd_bench.h"
+#include "boot_timeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <unistd.h> // getpid
+#endif
+
+#if !CONFIG_IDF_TARGET_LINUX
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_event.h"
@@ -6,17 +20,54 @@
 #include "esp_wifi.h"  // Wi-Fi functions
 #include "esp_log.h"   // Logging macros
 #include "nvs_flash.h" // NVS storage (required for Wi-Fi credentials)
+#include "esp_mac.h"   // eFuse MAC, for the device id
 
-#include <sys/socket.h> // Core socket functions
-#include <netinet/in.h> // sockaddr_in struct and INADDR_ANY
-#include <string.h>
-#include <arpa/inet.h> // inet_pton and address manipulation
-
-// #include "esp_timer.h"
-#include <stdio.h>
+#include "wifi_cache.h"
 
 static EventGroupHandle_t wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
+#define WIFI_FAST_MAX_FAILURES 2 // failed connects to the cached AP before falling back to a scan
+
+static esp_netif_t *s_sta_netif;
+static wifi_config_t s_wifi_config;
+static int s_fast_connect; // connecting to the cached BSSID/channel
+static int s_static_ip;    // the cached lease is set as a static IP, DHCP is stopped
+static int s_fast_failures;
+
+// Forget the cached association and connect the slow way: full scan, then DHCP
+static void wifi_fast_fallback(void)
+{
+    printf("Cached AP not reachable, scanning\n");
+    wifi_cache_clear();
+    s_fast_connect = 0;
+    s_wifi_config.sta.bssid_set = false;
+    s_wifi_config.sta.channel = 0;
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+    if (s_static_ip)
+    {
+        s_static_ip = 0;
+        esp_netif_dhcpc_start(s_sta_netif);
+    }
+}
+
+// Keep the association and lease for the next boot, wifi_cache_store() skips an unchanged entry
+static void wifi_fast_save(const esp_netif_ip_info_t *ip_info)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK)
+    {
+        return;
+    }
+    wifi_cache_t cache = {
+        .channel = ap.primary,
+        .ip = ip_info->ip.addr,
+        .netmask = ip_info->netmask.addr,
+        .gw = ip_info->gw.addr,
+    };
+    strlcpy(cache.ssid, CONFIG_UDP_WIFI_SSID, sizeof(cache.ssid));
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    wifi_cache_store(&cache);
+}
 
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data)
@@ -25,15 +76,28 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
     {
         esp_wifi_connect();
     }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED)
+    {
+        boot_timeline_mark(BOOT_PHASE_ASSOCIATED);
+        s_fast_failures = 0;
+    }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
     {
         printf("Wi-Fi disconnected. Retrying...\n");
+        if (s_fast_connect && ++s_fast_failures >= WIFI_FAST_MAX_FAILURES)
+        {
+            wifi_fast_fallback();
+        }
         esp_wifi_connect();
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
     {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        printf("Got IP: " IPSTR "\n", IP2STR(&event->ip_info.ip));
+        boot_timeline_mark(BOOT_PHASE_GOT_IP);
+        printf("Got IP: " IPSTR "%s\n", IP2STR(&event->ip_info.ip), s_static_ip ? " (cached)" : "");
+#if CONFIG_UDP_WIFI_FAST_CONNECT
+        wifi_fast_save(&event->ip_info);
+#endif
         xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
@@ -46,14 +110,18 @@ void wifi_init_sta()
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
     {
         ESP_ERROR_CHECK(nvs_flash_erase());
+        boot_timeline_mark(BOOT_PHASE_NVS_ERASE);
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_timeline_mark(BOOT_PHASE_NVS_INIT);
 
     esp_netif_init(); // Initialize TCP/IP network interface (mandatory)
+    boot_timeline_mark(BOOT_PHASE_NETIF_INIT);
     wifi_event_group = xEventGroupCreate();
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta(); // Create default Wi-Fi station interface
+    boot_timeline_mark(BOOT_PHASE_EVENT_LOOP);
+    s_sta_netif = esp_netif_create_default_wifi_sta(); // Create default Wi-Fi station interface
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &wifi_event_handler,
@@ -68,74 +136,107 @@ void wifi_init_sta()
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
 
     esp_wifi_init(&cfg); // Initialize Wi-Fi with default config
+    boot_timeline_mark(BOOT_PHASE_WIFI_INIT);
 
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = "hank_EXT",    // Replace with actual SSID
-            .password = "23715019" // Replace with actual password
-        },
-    };
+    strlcpy((char *)s_wifi_config.sta.ssid, CONFIG_UDP_WIFI_SSID, sizeof(s_wifi_config.sta.ssid));             // Set with idf.py menuconfig
+    strlcpy((char *)s_wifi_config.sta.password, CONFIG_UDP_WIFI_PASSWORD, sizeof(s_wifi_config.sta.password)); // Set with idf.py menuconfig
+
+#if CONFIG_UDP_WIFI_FAST_CONNECT
+    // Probe the AP of the last connect on its channel only, instead of scanning every channel
+    wifi_cache_t cache;
+    if (wifi_cache_load(CONFIG_UDP_WIFI_SSID, &cache) == 0)
+    {
+        s_fast_connect = 1;
+        s_wifi_config.sta.bssid_set = true;
+        memcpy(s_wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+        s_wifi_config.sta.channel = cache.channel;
+        printf("Fast connect to " MACSTR " on channel %u\n", MAC2STR(cache.bssid), cache.channel);
+#if CONFIG_UDP_WIFI_STATIC_IP
+        // Reuse the last lease, the got-IP event comes right after association instead of after DHCP
+        esp_netif_ip_info_t ip_info = {
+            .ip.addr = cache.ip,
+            .netmask.addr = cache.netmask,
+            .gw.addr = cache.gw,
+        };
+        if (cache.ip != 0 && esp_netif_dhcpc_stop(s_sta_netif) == ESP_OK &&
+            esp_netif_set_ip_info(s_sta_netif, &ip_info) == ESP_OK)
+        {
+            s_static_ip = 1;
+        }
+#endif
+    }
+#endif
 
-    esp_wifi_set_mode(WIFI_MODE_STA);               // Set station mode
-    esp_wifi_set_config(WIFI_IF_STA, &wifi_config); // Apply config to STA interface
-    esp_wifi_start();                               // Start Wi-Fi driver
+    esp_wifi_set_mode(WIFI_MODE_STA);                 // Set station mode
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config); // Apply config to STA interface
+    esp_wifi_start();                                 // Start Wi-Fi driver
+    boot_timeline_mark(BOOT_PHASE_WIFI_START);
+}
+
+#endif // !CONFIG_IDF_TARGET_LINUX
+
+// UDP_DEVICE_ID, or ESP32_ and the last three bytes of the eFuse MAC if it's empty
+static const char *device_id(void)
+{
+    static char id[CMD_PROTO_ID_LEN + 1];
+    if (strlen(CONFIG_UDP_DEVICE_ID) > 0)
+    {
+        return CONFIG_UDP_DEVICE_ID;
+    }
+#if CONFIG_IDF_TARGET_LINUX
+    // no eFuse on the host, the process id tells instances apart
+    snprintf(id, sizeof(id), "LINUX_%06X", (unsigned)getpid() & 0xFFFFFF);
+#else
+    uint8_t mac[6];
+    esp_efuse_mac_get_default(mac);
+    snprintf(id, sizeof(id), "ESP32_%02X%02X%02X", mac[3], mac[4], mac[5]);
+#endif
+    return id;
 }
 
 void app_main(void)
 {
+    boot_timeline_mark(BOOT_PHASE_APP_MAIN);
+#if !CONFIG_IDF_TARGET_LINUX
     wifi_init_sta();
     printf("Waiting for Wi-Fi connection...\n");
     xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT, false, true, portMAX_DELAY);
     printf("✅ Wi-Fi connected successfully!\n");
-
-    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP); // Create IPv4 UDP socket
-    int broadcast = 1;
-    if (setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast)) < 0)
+    boot_timeline_set_note(s_static_ip ? "cached AP and IP" : s_fast_connect ? "cached AP" : "scan");
+#endif
+
+#if CONFIG_UDP_CMD_BENCHMARK
+    cmd_bench_run();
+#endif
+
+    // the service task keeps running after app_main returns
+    cmd_service_config_t config = {
+        .cmd_port = CONFIG_UDP_CMD_PORT,
+        .multicast_group = CONFIG_UDP_CMD_MULTICAST_GROUP,
+        .announce_ip = CONFIG_UDP_SERVER_IP,
+        .announce_port = CONFIG_UDP_ACK_PORT,
+        .announce_interval_s = CONFIG_UDP_ANNOUNCE_INTERVAL_S,
+        .telemetry_interval_s = CONFIG_UDP_TELEMETRY_INTERVAL_S,
+        .device_id = device_id(),
+    };
+#if CONFIG_IDF_TARGET_LINUX
+    // several host instances can run side by side, each with its own id and port
+    if (getenv("UDP_DEVICE_ID"))
     {
-        perror("setsockopt failed");
-        return;
+        config.device_id = getenv("UDP_DEVICE_ID");
     }
-
-    // bind to a port
-    struct sockaddr_in listen_addr;
-    listen_addr.sin_family = AF_INET;                // IPv4
-    listen_addr.sin_port = htons(12345);             // Host-to-network byte order for port
-    listen_addr.sin_addr.s_addr = htonl(INADDR_ANY); // Listen on any local IP
-
-    // bind(sock, (struct sockaddr *)&listen_addr, sizeof(listen_addr)); // Bind socket to port
-    if (bind(sock, (struct sockaddr *)&listen_addr, sizeof(listen_addr)) < 0)
+    if (getenv("UDP_CMD_PORT"))
     {
-        perror("bind failed");
-        return;
+        config.cmd_port = atoi(getenv("UDP_CMD_PORT"));
     }
-    else
+    if (getenv("UDP_MULTICAST_GROUP"))
     {
-        printf("Bind succuessfully\n");
+        config.multicast_group = getenv("UDP_MULTICAST_GROUP");
     }
-
-    // receive UDP broadcast
-    char rx_buffer[256];
-    struct sockaddr_in source_addr; // Will hold sender's info
-    socklen_t socklen = sizeof(source_addr);
-    printf("Start waiting for UDP broadcast...\n");
-
-    int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0,
-                       (struct sockaddr *)&source_addr, &socklen); // Blocking receive
-    printf("len = %d\n", len);
-    if (len > 0)
+#endif
+    if (cmd_service_start(&config) != 0)
     {
-        rx_buffer[len] = 0; // Null-terminate string for safety
-        printf("Received: %s\n", rx_buffer);
+        printf("Failed to start command service\n");
     }
-
-    // send ACK
-
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(3333);                         // Server ACK port
-    inet_pton(AF_INET, "192.168.1.100", &dest_addr.sin_addr); // Convert IP string to binary form
-
-    char *ack_msg = "{ \"id\": \"ESP32_A\", \"status\": \"ack\" }";
-    sendto(sock, ack_msg, strlen(ack_msg), 0,
-           (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    boot_timeline_print(); // the service sends the same to the announce address
 }
@@ -0,0 +1,260 @@
+#include "telemetry.h"
+#include "cmd_proto.h"
+
+#include "sdkconfig.h"
+#include "esp_timer.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_system.h" // heap sizes
+#include "esp_wifi.h"   // RSSI
+#endif
+
+#include <string.h>
+
+#define TELEMETRY_SAMPLE_US 1000000 // gauge sampling period
+#define TELEMETRY_CORES 2            // cores the payload has room for
+
+static uint32_t s_interval_ms;
+static int64_t s_window_start_us;
+static int64_t s_next_sample_us;
+static uint32_t s_report_seq;
+
+// Command latencies of the window, the only part written from other tasks
+static struct
+{
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t sum_us;
+    uint16_t buckets[TELEMETRY_BUCKETS];
+    int full; // a bucket reached UINT16_MAX, the report is due
+} s_latency;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Gauges of the window, only touched by the polling task
+static int s_rssi_min;
+static int s_rssi_max;
+static int s_rssi_sum;
+static int s_rssi_samples;
+static int s_samples;
+
+typedef struct
+{
+    TaskHandle_t task;
+    char name[TELEMETRY_TASK_NAME_LEN];
+} watched_task_t;
+
+// Appended by telemetry_watch_task while the worker may be reporting, both sides hold s_lock
+static watched_task_t s_tasks[TELEMETRY_MAX_TASKS];
+static int s_task_count;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && !CONFIG_IDF_TARGET_LINUX
+// Run time counters at the start of the window, the load is the part the idle task didn't get
+static configRUN_TIME_COUNTER_TYPE s_idle_start[TELEMETRY_CORES];
+static configRUN_TIME_COUNTER_TYPE s_total_start;
+
+static void cpu_window_start(void)
+{
+    for (int core = 0; core < portNUM_PROCESSORS && core < TELEMETRY_CORES; core++)
+    {
+        s_idle_start[core] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    }
+    s_total_start = portGET_RUN_TIME_COUNTER_VALUE();
+}
+
+static uint8_t cpu_load(int core)
+{
+    if (core >= portNUM_PROCESSORS)
+    {
+        return TELEMETRY_CPU_UNKNOWN;
+    }
+    configRUN_TIME_COUNTER_TYPE idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core)) - s_idle_start[core];
+    configRUN_TIME_COUNTER_TYPE total = portGET_RUN_TIME_COUNTER_VALUE() - s_total_start;
+    if (total == 0 || idle >= total)
+    {
+        return 0;
+    }
+    return (uint8_t)(100 - (uint64_t)idle * 100 / total);
+}
+#else
+// Needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static void cpu_window_start(void)
+{
+}
+
+static uint8_t cpu_load(int core)
+{
+    return TELEMETRY_CPU_UNKNOWN;
+}
+#endif
+
+static void window_start(int64_t now)
+{
+    s_window_start_us = now;
+    s_rssi_min = 0;
+    s_rssi_max = 0;
+    s_rssi_sum = 0;
+    s_rssi_samples = 0;
+    s_samples = 0;
+    cpu_window_start();
+}
+
+void telemetry_init(uint32_t interval_ms)
+{
+    s_interval_ms = interval_ms;
+    int64_t now = esp_timer_get_time();
+    s_next_sample_us = now;
+    window_start(now);
+}
+
+void telemetry_watch_task(TaskHandle_t task, const char *name)
+{
+    if (task == NULL)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    if (s_task_count < TELEMETRY_MAX_TASKS)
+    {
+        s_tasks[s_task_count].task = task;
+        strncpy(s_tasks[s_task_count].name, name, TELEMETRY_TASK_NAME_LEN);
+        s_task_count++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void telemetry_record_latency(uint32_t latency_us)
+{
+    int bucket = 0;
+    while (bucket < TELEMETRY_BUCKETS - 1 && latency_us >= (2u << bucket))
+    {
+        bucket++;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_latency.count++;
+    s_latency.sum_us = latency_us > UINT32_MAX - s_latency.sum_us ? UINT32_MAX : s_latency.sum_us + latency_us;
+    if (latency_us > s_latency.max_us)
+    {
+        s_latency.max_us = latency_us;
+    }
+    if (s_latency.buckets[bucket] < UINT16_MAX)
+    {
+        s_latency.buckets[bucket]++;
+    }
+    if (s_latency.buckets[bucket] == UINT16_MAX)
+    {
+        s_latency.full = 1;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void sample_gauges(void)
+{
+    s_samples++;
+#if !CONFIG_IDF_TARGET_LINUX
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK)
+    {
+        if (s_rssi_samples == 0 || ap.rssi < s_rssi_min)
+        {
+            s_rssi_min = ap.rssi;
+        }
+        if (s_rssi_samples == 0 || ap.rssi > s_rssi_max)
+        {
+            s_rssi_max = ap.rssi;
+        }
+        s_rssi_sum += ap.rssi;
+        s_rssi_samples++;
+    }
+#endif
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+size_t telemetry_poll(const char *device_id, uint8_t *buf, size_t size)
+{
+    if (s_interval_ms == 0)
+    {
+        return 0;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now >= s_next_sample_us)
+    {
+        sample_gauges();
+        s_next_sample_us += TELEMETRY_SAMPLE_US;
+        if (s_next_sample_us <= now)
+        {
+            s_next_sample_us = now + TELEMETRY_SAMPLE_US; // the task was held up, don't catch up
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    int full = s_latency.full;
+    portEXIT_CRITICAL(&s_lock);
+    if ((now - s_window_start_us < (int64_t)s_interval_ms * 1000 && !full) ||
+        size < CMD_PROTO_FRAME_SIZE + TELEMETRY_PAYLOAD_SIZE)
+    {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t count = s_latency.count;
+    uint32_t max_us = s_latency.max_us;
+    uint32_t sum_us = s_latency.sum_us;
+    uint16_t buckets[TELEMETRY_BUCKETS];
+    memcpy(buckets, s_latency.buckets, sizeof(buckets));
+    memset(&s_latency, 0, sizeof(s_latency));
+    // the stack watermarks are read outside the critical section, it only copies the list
+    watched_task_t tasks[TELEMETRY_MAX_TASKS];
+    int task_count = s_task_count;
+    memcpy(tasks, s_tasks, task_count * sizeof(tasks[0]));
+    portEXIT_CRITICAL(&s_lock);
+
+    cmd_msg_t header = {
+        .version = CMD_PROTO_VERSION,
+        .cmd = CMD_PROTO_CMD_TELEMETRY,
+        .seq = s_report_seq++,
+        .delay_ms = (uint32_t)((now - s_window_start_us) / 1000),
+        .timestamp_us = now,
+    };
+    strncpy(header.device_id, device_id, CMD_PROTO_ID_LEN);
+    size_t len = cmd_proto_encode(&header, buf, size);
+    uint8_t *p = buf + len;
+
+#if CONFIG_IDF_TARGET_LINUX
+    cmd_proto_put_u32(p, 0);
+    cmd_proto_put_u32(p + 4, 0);
+#else
+    cmd_proto_put_u32(p, esp_get_free_heap_size());
+    cmd_proto_put_u32(p + 4, esp_get_minimum_free_heap_size());
+#endif
+    p[8] = (uint8_t)(int8_t)s_rssi_min;
+    p[9] = (uint8_t)(int8_t)(s_rssi_samples ? s_rssi_sum / s_rssi_samples : 0);
+    p[10] = (uint8_t)(int8_t)s_rssi_max;
+    p[11] = s_samples > UINT8_MAX ? UINT8_MAX : s_samples;
+    p[12] = cpu_load(0);
+    p[13] = cpu_load(1);
+    put_u16(p + 14, full ? TELEMETRY_FLAG_EARLY : 0);
+    cmd_proto_put_u32(p + 16, count);
+    cmd_proto_put_u32(p + 20, max_us);
+    cmd_proto_put_u32(p + 24, sum_us);
+    for (int i = 0; i < TELEMETRY_BUCKETS; i++)
+    {
+        put_u16(p + 28 + 2 * i, buckets[i]);
+    }
+    p[60] = task_count;
+    p += 61;
+    for (int i = 0; i < task_count; i++)
+    {
+        UBaseType_t free_bytes = uxTaskGetStackHighWaterMark(tasks[i].task); // bytes on ESP-IDF
+        memcpy(p, tasks[i].name, TELEMETRY_TASK_NAME_LEN);
+        put_u16(p + TELEMETRY_TASK_NAME_LEN, free_bytes > UINT16_MAX ? UINT16_MAX : free_bytes);
+        p += TELEMETRY_TASK_NAME_LEN + 2;
+    }
+
+    window_start(now);
+    return p - buf;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Device health, aggregated on the device and sent as one datagram per window.
+//
+// Events (command latencies) go into a fixed log2 histogram, the RSSI is sampled once a second into
+// min/avg/max, and the CPU load is the share of the window the idle tasks didn't get. The free heap,
+// its low-water mark since boot and the stack high-water marks of the watched tasks are read when
+// the report is built. Nothing is buffered per event, so the report has the same size however busy
+// the window was. It's built early when a histogram bucket is about to overflow.
+//
+// The report is a CMD_PROTO_CMD_TELEMETRY frame (seq: report count, delay_ms: length of the window)
+// followed by this payload, network byte order, mirrored by TELEMETRY in server/server.py:
+//
+//   offset  size  field
+//        0     4  heap_free, bytes when the report was built
+//        4     4  heap_min_free, lowest since boot
+//        8     1  rssi_min, int8 dBm, 0 if there was no sample
+//        9     1  rssi_avg
+//       10     1  rssi_max
+//       11     1  sampling rounds in the window, one a second
+//       12     2  cpu load of core 0 and 1 in %, TELEMETRY_CPU_UNKNOWN if not measured
+//       14     2  flags, TELEMETRY_FLAG_*
+//       16     4  latency count, commands handled in the window
+//       20     4  latency max in us
+//       24     4  latency sum in us, saturating
+//       28    32  latency histogram, 16 x u16, bucket i counts [2^i, 2^(i+1)) us, 0 is [0, 2), 15 is >= 32768
+//       60     1  watched tasks n
+//       61  10*n  per task: name, 8 bytes zero padded, and u16 stack high-water mark in bytes
+
+#define TELEMETRY_BUCKETS 16
+#define TELEMETRY_MAX_TASKS 4
+#define TELEMETRY_TASK_NAME_LEN 8
+#define TELEMETRY_PAYLOAD_SIZE (61 + TELEMETRY_MAX_TASKS * (TELEMETRY_TASK_NAME_LEN + 2)) // largest one
+#define TELEMETRY_CPU_UNKNOWN 0xFF
+#define TELEMETRY_FLAG_EARLY 0x0001 // built before the window was over, a bucket was full
+
+// Start a window. interval_ms 0 disables the reports
+void telemetry_init(uint32_t interval_ms);
+
+// Report the stack high-water mark of task under name, up to TELEMETRY_MAX_TASKS of them
+void telemetry_watch_task(TaskHandle_t task, const char *name);
+
+// Count one command, latency from its reception to its handler. Safe from any task
+void telemetry_record_latency(uint32_t latency_us);
+
+// Sample the RSSI when due and, when the window is over or the histogram is full, write the
+// report for device_id into buf and start the next window. Meant to be called often from one task.
+// Returns the report size, 0 if there is nothing to send yet
+size_t telemetry_poll(const char *device_id, uint8_t *buf, size_t size);
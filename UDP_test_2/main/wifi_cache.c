@@ -0,0 +1,97 @@
+#include "wifi_cache.h"
+
+#include "nvs.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define WIFI_CACHE_NAMESPACE "wifi_cache"
+#define WIFI_CACHE_KEY "assoc"
+#define WIFI_CACHE_VERSION 1 // bump when wifi_cache_t changes, older blobs are ignored
+
+typedef struct
+{
+    uint8_t version;
+    wifi_cache_t cache;
+} wifi_cache_blob_t;
+
+static int read_blob(wifi_cache_blob_t *blob)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return -1; // namespace not created yet, nothing was stored
+    }
+    size_t len = sizeof(*blob);
+    esp_err_t err = nvs_get_blob(handle, WIFI_CACHE_KEY, blob, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len != sizeof(*blob) || blob->version != WIFI_CACHE_VERSION)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int wifi_cache_load(const char *ssid, wifi_cache_t *cache)
+{
+    wifi_cache_blob_t blob;
+    if (read_blob(&blob) != 0)
+    {
+        return -1;
+    }
+    blob.cache.ssid[sizeof(blob.cache.ssid) - 1] = '\0';
+    if (strcmp(blob.cache.ssid, ssid) != 0 || blob.cache.channel == 0)
+    {
+        return -1;
+    }
+    *cache = blob.cache;
+    return 0;
+}
+
+int wifi_cache_store(const wifi_cache_t *cache)
+{
+    wifi_cache_blob_t blob;
+    memset(&blob, 0, sizeof(blob)); // padding is part of the comparison below
+    blob.version = WIFI_CACHE_VERSION;
+    blob.cache = *cache;
+
+    wifi_cache_blob_t stored;
+    if (read_blob(&stored) == 0 && memcmp(&stored, &blob, sizeof(blob)) == 0)
+    {
+        return 0;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+    {
+        printf("Wi-Fi cache: nvs_open failed: %s\n", esp_err_to_name(err));
+        return -1;
+    }
+    err = nvs_set_blob(handle, WIFI_CACHE_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK)
+    {
+        printf("Wi-Fi cache: write failed: %s\n", esp_err_to_name(err));
+        return -1;
+    }
+    return 0;
+}
+
+void wifi_cache_clear(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if (nvs_erase_key(handle, WIFI_CACHE_KEY) == ESP_OK)
+    {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
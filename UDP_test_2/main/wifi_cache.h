@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// Association of the last successful Wi-Fi connect, kept in NVS for the fast connect path.
+//
+// With the BSSID and channel known the driver probes that one channel instead of scanning all of
+// them, and with the address of the last lease the DHCP exchange can be skipped as well. The entry
+// is tied to the SSID it was made for, a changed UDP_WIFI_SSID ignores it.
+
+typedef struct
+{
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip; // last DHCP lease, network byte order as in esp_ip4_addr_t
+    uint32_t netmask;
+    uint32_t gw;
+} wifi_cache_t;
+
+// Read the entry for ssid. Returns 0 if there is one, -1 otherwise
+int wifi_cache_load(const char *ssid, wifi_cache_t *cache);
+
+// Write the entry, unless the stored one is the same (no flash write on a fast boot). Returns 0 on success
+int wifi_cache_store(const wifi_cache_t *cache);
+
+// Drop the entry, the next boot scans and uses DHCP
+void wifi_cache_clear(void);
@@ -0,0 +1,207 @@
+"""Record, inspect and replay the session traffic.
+
+record   listen on the command and server ports and log the datagrams seen there. Broadcast and
+         multicast traffic only: unicast replies go to the server's socket, log those with
+         server.py --capture instead. Neither server.py nor a linux-target device build sets
+         SO_REUSEADDR, since a second socket on the port could take their unicast datagrams, so
+         record has to run on another host than they do
+show     print the command round trips of a capture log
+compare  print the round trips of two capture logs side by side
+replay   send the commands of a capture log again, with the same spacing or time-scaled, to a
+         linux-target device build or the fleet simulator, and compare the round trips
+
+A round trip is the time from the first send of a command to a device's first reply to it, so
+retransmits count against it."""
+import argparse
+import collections
+import select
+import socket
+import time
+
+from server import (ACK_PORT, CAPTURE_FROM_DEVICE, CAPTURE_TO_DEVICE, CMD_START, CaptureLog, decode_frame,
+                    decode_message, encode_frame, open_socket, percentile, read_capture)
+
+# Commands whose replies carry their session and seq, and the reply
+REPLY_TO = {"start": "ack", "stop": "ack", "time_query": "time_reply", "sync": "delay_req"}
+
+
+def message_kind(data):
+    """cmd of a datagram (status for a JSON ACK) and the decoded message, (None, None) if it isn't one"""
+    try:
+        msg = decode_message(data)
+    except ValueError:
+        return None, None
+    if not isinstance(msg, dict):
+        return None, None
+    return msg.get("cmd") or msg.get("status"), msg
+
+
+def round_trips(records):
+    """Round trips in ms by command, and the commands sent, of a list of capture records"""
+    first_sent = {}  # (reply, session, seq) -> (command, send time)
+    answered = set()
+    rtts = collections.defaultdict(list)
+    sent = collections.Counter()
+    for t_ns, direction, addr, data in records:
+        kind, msg = message_kind(data)
+        if direction == CAPTURE_TO_DEVICE and kind in REPLY_TO:
+            key = (REPLY_TO[kind], msg.get("session"), msg.get("seq"))
+            if key not in first_sent:
+                first_sent[key] = (kind, t_ns)
+                sent[kind] += 1
+        elif direction == CAPTURE_FROM_DEVICE:
+            key = (kind, msg and msg.get("session"), msg and msg.get("seq"))
+            if key in first_sent and (key, msg.get("id")) not in answered:
+                answered.add((key, msg.get("id")))
+                command, t_sent = first_sent[key]
+                rtts[command].append((t_ns - t_sent) / 1e6)
+    return rtts, sent
+
+
+def describe(rtts):
+    if not rtts:
+        return "no replies"
+    return f"{len(rtts)} replies, ms: p50 {percentile(rtts, 50):.3f} p99 {percentile(rtts, 99):.3f} " \
+           f"max {max(rtts):.3f}"
+
+
+def print_round_trips(tag, records):
+    rtts, sent = round_trips(records)
+    for command in sorted(sent):
+        print(f"[{tag}] {command}: {sent[command]} sent, {describe(rtts[command])}")
+
+
+def print_comparison(tag, before, after, commands=None):
+    """Round trips of two runs of the same traffic, and the difference of their percentiles.
+    Only of commands, if given"""
+    rtts_a, sent_a = round_trips(before)
+    rtts_b, sent_b = round_trips(after)
+    for command in sorted((set(sent_a) | set(sent_b)) & (commands or set(REPLY_TO))):
+        a, b = rtts_a[command], rtts_b[command]
+        print(f"[{tag}] {command}: {sent_a[command]} / {sent_b[command]} sent, "
+              f"{len(a)} / {len(b)} replies")
+        if a and b:
+            for p in (50, 90, 99):
+                pa, pb = percentile(a, p), percentile(b, p)
+                print(f"[{tag}]   p{p:<3} {pa:9.3f} ms -> {pb:9.3f} ms ({pb - pa:+.3f})")
+            print(f"[{tag}]   max  {max(a):9.3f} ms -> {max(b):9.3f} ms ({max(b) - max(a):+.3f})")
+
+
+def record(path, ports, duration_s):
+    """Log what arrives on ports; the server port gets device traffic, the others commands"""
+    socks = {}
+    for port in ports:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)  # next to other broadcast listeners
+        try:
+            sock.bind(("", port))
+        except OSError as e:
+            raise SystemExit(f"[RECORD] can't listen on port {port}: {e}. A server or device on this "
+                             f"host holds it without SO_REUSEADDR, record from another host")
+        socks[sock] = port
+    capture = CaptureLog(path)
+    count = 0
+    until = time.monotonic() + duration_s if duration_s else None
+    try:
+        while until is None or time.monotonic() < until:
+            timeout = None if until is None else max(0.0, until - time.monotonic())
+            for sock in select.select(list(socks), [], [], timeout)[0]:
+                data, addr = sock.recvfrom(2048)
+                if socks[sock] == ACK_PORT:
+                    capture.write(CAPTURE_FROM_DEVICE, addr, data)
+                else:
+                    capture.write(CAPTURE_TO_DEVICE, ("0.0.0.0", socks[sock]), data)
+                count += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        capture.close()
+        for sock in socks:
+            sock.close()
+    print(f"[RECORD] {count} datagrams logged to {path}")
+
+
+def shift_start(data, shift_us):
+    """data with the start time of a binary START moved by shift_us, other datagrams unchanged.
+    ref_us is absolute on the server clock, a replay would name a time long past. JSON starts only
+    carry the relative delay_ms"""
+    msg = decode_frame(data)
+    if msg is None or msg["cmd"] != "start" or not msg["ref_us"]:
+        return data
+    return encode_frame(CMD_START, msg["seq"], msg["session"], msg["delay_ms"], msg["id"],
+                        msg["timestamp_us"] + shift_us, ref_us=msg["ref_us"] + shift_us)
+
+
+def replay(records, ip, speed, commands, tail_s=1.0):
+    """Send the commands of records to ip, on their original ports, spaced like they were divided by
+    speed. The devices reply to the sender, this socket. Returns the replay as capture records"""
+    sends = [(t_ns, addr, data) for t_ns, direction, addr, data in records
+             if direction == CAPTURE_TO_DEVICE and message_kind(data)[0] in commands]
+    sock = open_socket(0)
+    events = []
+    shifts = {}  # (session, seq) of a start -> shift of its first send, kept for its retransmits
+
+    def receive(until_ns):
+        while (remaining := until_ns - time.monotonic_ns()) > 0:
+            if not select.select([sock], [], [], remaining / 1e9)[0]:
+                break
+            while select.select([sock], [], [], 0)[0]:
+                data, addr = sock.recvfrom(2048)
+                events.append((time.monotonic_ns(), CAPTURE_FROM_DEVICE, addr, data))
+
+    t0 = time.monotonic_ns()
+    for t_ns, addr, data in sends:
+        receive(t0 + int((t_ns - sends[0][0]) / speed))  # paced on the start, a late send doesn't shift the rest
+        dest = (ip, addr[1])
+        kind, msg = message_kind(data)
+        if kind == "start":
+            # the start keeps the lead time it had over its first send
+            shift_us = shifts.setdefault((msg.get("session"), msg.get("seq")), (time.monotonic_ns() - t_ns) // 1000)
+            data = shift_start(data, shift_us)
+        events.append((time.monotonic_ns(), CAPTURE_TO_DEVICE, dest, data))
+        sock.sendto(data, dest)
+    receive(time.monotonic_ns() + int(tail_s * 1e9))
+    sock.close()
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record, inspect and replay the session traffic")
+    sub = parser.add_subparsers(dest="action", required=True)
+    p = sub.add_parser("record", help="log the broadcast traffic on the command and server ports")
+    p.add_argument("file")
+    p.add_argument("--ports", type=int, nargs="+", default=[12345, ACK_PORT], help="ports to listen on")
+    p.add_argument("--duration", type=float, help="stop after this many seconds, by default on Ctrl-C")
+    p = sub.add_parser("show", help="print the command round trips of a capture log")
+    p.add_argument("file")
+    p = sub.add_parser("compare", help="compare the round trips of two capture logs")
+    p.add_argument("before")
+    p.add_argument("after")
+    p = sub.add_parser("replay", help="send the commands of a capture log again and compare the round trips")
+    p.add_argument("file")
+    p.add_argument("--ip", default="127.0.0.1", help="device address, the original ports are kept")
+    p.add_argument("--speed", type=float, default=1.0, help="time scale, 2 replays twice as fast")
+    p.add_argument("--cmds", nargs="+", default=["start", "stop", "time_query", "discover", "stats", "boot"],
+                   help="commands to replay. SYNC and DELAY_RESP aren't by default, their timestamps are stale")
+    p.add_argument("--out", metavar="FILE", help="also write the replay as a capture log")
+    args = parser.parse_args()
+
+    if args.action == "record":
+        record(args.file, args.ports, args.duration)
+    elif args.action == "show":
+        print_round_trips("CAPTURE", list(read_capture(args.file)))
+    elif args.action == "compare":
+        print_comparison("COMPARE", list(read_capture(args.before)), list(read_capture(args.after)))
+    else:
+        original = list(read_capture(args.file))
+        events = replay(original, args.ip, args.speed, set(args.cmds))
+        if args.out:
+            capture = CaptureLog(args.out)
+            for t_ns, direction, addr, data in events:
+                capture.write(direction, addr, data, t_ns)
+            capture.close()
+        print_comparison("REPLAY", original, events, set(args.cmds))
+
+
+if __name__ == "__main__":
+    main()
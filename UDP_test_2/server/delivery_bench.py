@@ -0,0 +1,85 @@
+"""Compare how commands reach the devices by subnet broadcast and by multicast.
+
+Sends TIME_QUERY frames, which every device answers right away, with each addressing mode in
+turn, and prints per mode the replies that were lost and the round trip distribution."""
+import argparse
+import collections
+import random
+import select
+import time
+
+from server import (CMD_TIME_QUERY, broadcast_address, decode_message, encode_frame, open_socket,
+                    percentile)
+
+
+def run_mode(sock, dest_ip, ports, count, interval_s, tail_s=0.5):
+    """Send count queries to dest_ip, interval_s apart. Returns {device id: [round trip in s]}"""
+    session = random.getrandbits(32)  # tells this run's replies from late ones of the previous mode
+    sent = {}
+    rtts = collections.defaultdict(list)
+
+    def receive(until):
+        while (remaining := until - time.monotonic()) > 0:
+            if not select.select([sock], [], [], remaining)[0]:
+                break
+            data, addr = sock.recvfrom(1024)
+            t_rx = time.monotonic()
+            try:
+                msg = decode_message(data)
+            except ValueError:
+                continue  # not a frame or JSON we understand
+            if not isinstance(msg, dict):
+                continue
+            if msg.get("cmd") == "time_reply" and msg["session"] == session and msg["seq"] in sent:
+                rtts[msg["id"]].append(t_rx - sent[msg["seq"]])
+
+    for seq in range(count):
+        sent[seq] = time.monotonic()
+        for port in ports:
+            sock.sendto(encode_frame(CMD_TIME_QUERY, seq, session), (dest_ip, port))
+        receive(sent[seq] + interval_s)
+    receive(time.monotonic() + tail_s)
+    return rtts
+
+
+def print_result(mode, rtts, devices, count):
+    replies = sum(len(r) for r in rtts.values())
+    expected = len(devices) * count
+    all_rtts = [rtt * 1000 for r in rtts.values() for rtt in r]
+    line = f"[{mode}] {len(rtts)}/{len(devices)} devices, {replies}/{expected} replies, " \
+           f"loss {100 * (1 - replies / expected) if expected else 0:.2f}%"
+    if all_rtts:
+        line += f", rtt ms: p50 {percentile(all_rtts, 50):.3f} p90 {percentile(all_rtts, 90):.3f} " \
+                f"p99 {percentile(all_rtts, 99):.3f} max {max(all_rtts):.3f}"
+    print(line)
+    for device_id in sorted(devices - set(rtts)):
+        print(f"[{mode}] no reply from {device_id}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare broadcast and multicast delivery to the devices")
+    parser.add_argument("--ip", help="broadcast address, by default the one of the local /24 network "
+                        "(127.255.255.255 for devices on this host)")
+    parser.add_argument("--multicast", default="239.255.0.1", metavar="GROUP",
+                        help="multicast group the devices joined, see UDP_CMD_MULTICAST_GROUP")
+    parser.add_argument("--ttl", type=int, default=1, help="multicast TTL")
+    parser.add_argument("--multicast-loop", action="store_true",
+                        help="deliver multicast queries to devices on this host too")
+    parser.add_argument("--ports", type=int, nargs="+", default=[12345], help="device command ports")
+    parser.add_argument("--count", type=int, default=200, help="queries per mode")
+    parser.add_argument("--interval-ms", type=float, default=10, help="time between queries")
+    args = parser.parse_args()
+
+    sock = open_socket(0, args.ttl, args.multicast_loop)
+    modes = [("broadcast", args.ip or broadcast_address()), ("multicast", args.multicast)]
+    results = {mode: run_mode(sock, dest_ip, args.ports, args.count, args.interval_ms / 1000)
+               for mode, dest_ip in modes}
+    # a device that answered in either mode is expected in both
+    devices = set().union(*(set(rtts) for rtts in results.values()))
+    for mode, dest_ip in modes:
+        print_result(f"{mode} {dest_ip}", results[mode], devices, args.count)
+    sock.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,100 @@
+"""Load the command service of one or more devices with a steady stream of commands.
+
+Sends binary commands at a fixed rate, matches every reply to its command by seq and prints the
+round trip distribution and the commands that got no reply. Then asks the devices for their stats,
+whose dropped and queue_max counters show whether the receive task had to drop commands because
+the worker fell behind."""
+import argparse
+import json
+import random
+import select
+import time
+
+from server import (CMD_START, CMD_STOP, CMD_TIME_QUERY, decode_message, encode_frame, open_socket,
+                    percentile)
+
+# command -> (frame cmd, reply cmd). TIME_QUERY is answered without any printing on the device,
+# START goes through the deduplication, the deadline scheduler and the console, like a real session
+COMMANDS = {"time_query": (CMD_TIME_QUERY, "time_reply"), "start": (CMD_START, "ack")}
+
+
+def run_load(sock, ip, ports, command, rate, duration_s, tail_s=0.5):
+    """Send rate commands per second to every port for duration_s.
+    Returns (commands sent, {(port, seq): round trip in s}, time the sending took)"""
+    cmd, reply_cmd = COMMANDS[command]
+    session = random.getrandbits(32)  # tells this run's replies from late ones of an earlier run
+    sent = {}
+    rtts = {}
+    count = int(rate * duration_s)
+    t0 = time.monotonic()
+
+    def receive(until):
+        while (remaining := until - time.monotonic()) > 0:
+            if not select.select([sock], [], [], remaining)[0]:
+                break
+            # take everything queued, at a high rate the replies arrive faster than one per wait
+            while select.select([sock], [], [], 0)[0]:
+                data, addr = sock.recvfrom(1024)
+                t_rx = time.monotonic()
+                try:
+                    msg = decode_message(data)
+                except ValueError:
+                    continue
+                if not isinstance(msg, dict):
+                    continue
+                key = (addr[1], msg.get("seq"))
+                if msg.get("cmd") == reply_cmd and msg.get("session") == session and key in sent:
+                    rtts.setdefault(key, t_rx - sent[key])
+
+    for seq in range(count):
+        # a long delay, the session is cancelled at the end instead of starting
+        frame = encode_frame(cmd, seq, session, delay_ms=60000)
+        for port in ports:
+            sent[(port, seq)] = time.monotonic()
+            sock.sendto(frame, (ip, port))
+        receive(t0 + (seq + 1) / rate)  # paced on the start time, a late send doesn't slow the rest
+    elapsed = time.monotonic() - t0
+    receive(time.monotonic() + tail_s)
+    if cmd == CMD_START:
+        for port in ports:
+            sock.sendto(encode_frame(CMD_STOP, count, session), (ip, port))
+    return len(sent), rtts, elapsed
+
+
+def print_device_stats(sock, ip, ports, wait_s=0.5):
+    for port in ports:
+        sock.sendto(json.dumps({"cmd": "stats"}).encode(), (ip, port))
+    until = time.monotonic() + wait_s
+    while (remaining := until - time.monotonic()) > 0 and select.select([sock], [], [], remaining)[0]:
+        msg = decode_message(sock.recvfrom(1024)[0])
+        if isinstance(msg, dict) and "packets" in msg:
+            print(f"[DEVICE] {msg['id']}: {msg['packets']} packets, {msg['dispatched']} handled, "
+                  f"{msg.get('dropped', 0)} dropped, queue max {msg.get('queue_max', 0)}, "
+                  f"receive to handler us: avg {msg['lat_avg_us']} max {msg['lat_max_us']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load the device command service at a fixed rate")
+    parser.add_argument("--ip", default="127.0.0.1", help="device address")
+    parser.add_argument("--ports", type=int, nargs="+", default=[12345], help="device command ports")
+    parser.add_argument("--cmd", choices=sorted(COMMANDS), default="time_query",
+                        help="command to send, every one is answered")
+    parser.add_argument("--rate", type=float, default=1000, help="commands per second to each port")
+    parser.add_argument("--duration", type=float, default=5, help="length of the run in s")
+    args = parser.parse_args()
+
+    sock = open_socket(0)
+    sent, rtts, elapsed = run_load(sock, args.ip, args.ports, args.cmd, args.rate, args.duration)
+    values = [rtt * 1000 for rtt in rtts.values()]
+    line = f"[LOAD] {args.cmd}: {sent} sent in {elapsed:.2f} s ({sent / elapsed:.0f}/s), " \
+           f"{len(rtts)} answered, {sent - len(rtts)} lost"
+    if values:
+        line += f", rtt ms: p50 {percentile(values, 50):.3f} p90 {percentile(values, 90):.3f} " \
+                f"p99 {percentile(values, 99):.3f} max {max(values):.3f}"
+    print(line)
+    print_device_stats(sock, args.ip, args.ports)
+    sock.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,96 +1,740 @@
+import asyncio
 import socket
 import time
 import json
 import contextlib
+import argparse
+import struct
+import timeit
+import random
 
-# socket.AF_INET = IPv4, socket.SOCK_DGRAM = UDP
-broadcast_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-
-# Enable broadcast mode
-broadcast_sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
-# Bind to all interfaces to allow broadcasting
-broadcast_sock.bind(('', 0))
-
-# Try to get the local network broadcast address, fallback to 255.255.255.255
-try:
-    # Get local IP to determine broadcast address
-    with contextlib.closing(socket.socket(socket.AF_INET, socket.SOCK_DGRAM)) as temp_sock:
-        temp_sock.connect(("8.8.8.8", 80))
-        # 8.8.8.8 is a public DNS server, used to determine the local IP
-        # This avoids sending packets to the internet, which is unnecessary for local broadcasts
-        local_ip = temp_sock.getsockname()[0]
-
-    # For most local networks, use the local broadcast (e.g., 192.168.1.255)
-    ip_parts = local_ip.split('.')
-    BROADCAST_IP = f"{ip_parts[0]}.{ip_parts[1]}.{ip_parts[2]}.255"
-    print(f"[INFO] Using broadcast IP: {BROADCAST_IP}")
-except Exception as e:
-    BROADCAST_IP = "255.255.255.255"
-    print(
-        f"[INFO] Using fallback broadcast IP: {BROADCAST_IP} due to error: {e}")
-
-START_PORT = 12345
-session_id = 42
-
-# Send start commands to devices
-for seq, delay in enumerate([10000, 9950, 9900]):
-    msg = {
-        "cmd": "start",
-        "seq": seq,
-        "delay_ms": delay,
-        "session": session_id
-    }
-    data = json.dumps(msg).encode('utf-8')
-    broadcast_sock.sendto(data, (BROADCAST_IP, START_PORT)
-                          )  # sendto: send UDP packet
-    time.sleep(0.05)  # space packets by 50ms
-    print(f"[Sent] {msg} to {BROADCAST_IP}:{START_PORT}")
-
-
-# Wait for ACKs from devices
+# Binary frame, same layout as main/cmd_proto.h: magic, version, cmd, seq, session,
+# delay_ms, device id (12 bytes, zero padded), timestamp_us, and from version 2 on
+# ref_us. Network byte order.
+PROTO_MAGIC = 0x5544
+PROTO_VERSION = 2
+FRAME = struct.Struct("!HBBIII12sq")
+FRAME_V2 = struct.Struct("!q")  # appended by version 2
+CMD_START, CMD_STOP, CMD_ACK = 1, 2, 3
+CMD_SYNC, CMD_DELAY_REQ, CMD_DELAY_RESP, CMD_TIME_QUERY, CMD_TIME_REPLY = 4, 5, 6, 7, 8
+CMD_REPORT, CMD_ANNOUNCE, CMD_DISCOVER, CMD_TELEMETRY = 9, 10, 11, 12
+CMD_NAMES = {CMD_START: "start", CMD_STOP: "stop", CMD_ACK: "ack", CMD_SYNC: "sync",
+             CMD_DELAY_REQ: "delay_req", CMD_DELAY_RESP: "delay_resp",
+             CMD_TIME_QUERY: "time_query", CMD_TIME_REPLY: "time_reply", CMD_REPORT: "report",
+             CMD_ANNOUNCE: "announce", CMD_DISCOVER: "discover", CMD_TELEMETRY: "telemetry"}
+
+# Payload of a TELEMETRY frame, same layout as main/telemetry.h: heap free and lowest free, RSSI
+# min/avg/max, gauge samples, CPU load of core 0 and 1, flags, command latency count/max/sum and
+# its 16-bucket log2 histogram, then the number of watched tasks and per task its name and stack
+# high-water mark
+TELEMETRY = struct.Struct("!IIbbbBBBHIII16HB")
+TELEMETRY_TASK = struct.Struct("!8sH")
+TELEMETRY_CPU_UNKNOWN = 0xFF
+TELEMETRY_FLAG_EARLY = 0x0001
+
+
+def now_us():
+    """Server clock, the time master of the devices. Monotonic, so it's shared by every
+    server process on this host"""
+    return time.monotonic_ns() // 1000
+
+
+def encode_frame(cmd, seq=0, session=0, delay_ms=0, device_id="", timestamp_us=None, ref_us=0):
+    if timestamp_us is None:
+        timestamp_us = now_us()
+    return FRAME.pack(PROTO_MAGIC, PROTO_VERSION, cmd, seq, session, delay_ms,
+                      device_id.encode(), timestamp_us) + FRAME_V2.pack(ref_us)
+
+
+def decode_frame(data):
+    """Decode a frame of any version into a dict, None if it isn't one.
+    Later versions only append fields, so the extra bytes are ignored."""
+    if len(data) < FRAME.size:
+        return None
+    magic, version, cmd, seq, session, delay_ms, device_id, timestamp_us = FRAME.unpack_from(data)
+    if magic != PROTO_MAGIC or version == 0:
+        return None
+    ref_us = 0
+    if version >= 2:
+        if len(data) < FRAME.size + FRAME_V2.size:
+            return None
+        ref_us, = FRAME_V2.unpack_from(data, FRAME.size)
+    msg = {"cmd": CMD_NAMES.get(cmd, cmd), "version": version, "seq": seq, "session": session,
+           "delay_ms": delay_ms, "id": device_id.rstrip(b"\0").decode(errors="replace"),
+           "timestamp_us": timestamp_us, "ref_us": ref_us}
+    if cmd == CMD_TELEMETRY:
+        msg["telemetry"] = decode_telemetry(data[FRAME.size + FRAME_V2.size:]) if version >= 2 else None
+    return msg
+
+
+def decode_telemetry(payload):
+    """Decode the payload of a TELEMETRY frame into a dict, None if it's truncated"""
+    if len(payload) < TELEMETRY.size:
+        return None
+    (heap_free, heap_min_free, rssi_min, rssi_avg, rssi_max, samples, cpu0, cpu1, flags,
+     count, max_us, sum_us, *rest) = TELEMETRY.unpack_from(payload)
+    buckets, tasks = rest[:-1], rest[-1]
+    if len(payload) < TELEMETRY.size + tasks * TELEMETRY_TASK.size:
+        return None
+    stacks = {}
+    for i in range(tasks):
+        name, free = TELEMETRY_TASK.unpack_from(payload, TELEMETRY.size + i * TELEMETRY_TASK.size)
+        stacks[name.rstrip(b"\0").decode(errors="replace")] = free
+    return {"heap_free": heap_free, "heap_min_free": heap_min_free,
+            "rssi": (rssi_min, rssi_avg, rssi_max) if rssi_avg else None, "samples": samples,
+            "cpu": [None if load == TELEMETRY_CPU_UNKNOWN else load for load in (cpu0, cpu1)],
+            "early": bool(flags & TELEMETRY_FLAG_EARLY),
+            "latency": {"count": count, "max_us": max_us, "sum_us": sum_us, "buckets": list(buckets)},
+            "stacks": stacks}
+
+
+def decode_message(data):
+    """Decode a datagram from a device, binary frame or JSON"""
+    if data[:2] == PROTO_MAGIC.to_bytes(2, "big"):
+        return decode_frame(data)
+    return json.loads(data.decode())
+
+
+def run_codec_benchmark(iterations=100000):
+    """Compare encode/decode cost and size of a start command, JSON vs binary"""
+    msg = {"cmd": "start", "seq": 1, "delay_ms": 9950, "session": 42}
+    json_data = json.dumps(msg).encode('utf-8')
+    frame = encode_frame(CMD_START, 1, 42, 9950)
+    cases = [
+        ("encode, JSON", lambda: json.dumps(msg).encode('utf-8'), len(json_data)),
+        ("encode, binary", lambda: encode_frame(CMD_START, 1, 42, 9950, "", 0), len(frame)),
+        ("decode, JSON", lambda: json.loads(json_data.decode()), len(json_data)),
+        ("decode, binary", lambda: decode_frame(frame), len(frame)),
+    ]
+    print(f"Start command codec benchmark, {iterations} iterations each")
+    for name, fn, size in cases:
+        ns = timeit.timeit(fn, number=iterations) * 1e9 / iterations
+        print(f"{name:16} {ns:8.0f} ns/op {size:5} bytes")
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of a non-empty list"""
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100 * len(values)))]
+
+
+def broadcast_address():
+    """Broadcast address of the local /24 network, fallback to 255.255.255.255"""
+    try:
+        # Get local IP to determine broadcast address
+        with contextlib.closing(socket.socket(socket.AF_INET, socket.SOCK_DGRAM)) as temp_sock:
+            temp_sock.connect(("8.8.8.8", 80))
+            # 8.8.8.8 is a public DNS server, used to determine the local IP
+            # This avoids sending packets to the internet, which is unnecessary for local broadcasts
+            local_ip = temp_sock.getsockname()[0]
+
+        # For most local networks, use the local broadcast (e.g., 192.168.1.255)
+        ip_parts = local_ip.split('.')
+        broadcast_ip = f"{ip_parts[0]}.{ip_parts[1]}.{ip_parts[2]}.255"
+        print(f"[INFO] Using broadcast IP: {broadcast_ip}")
+    except Exception as e:
+        broadcast_ip = "255.255.255.255"
+        print(f"[INFO] Using fallback broadcast IP: {broadcast_ip} due to error: {e}")
+    return broadcast_ip
+
+
+# The devices announce themselves to this port, and the commands are sent from it, so every
+# reply comes back here too
 ACK_PORT = 3333
-# the datatype is a set for fast membership testing
-EXPECTED_IDS = {"ESP32_A", "ESP32_B", "ESP32_C"}
 
-ack_sock = socket.socket(
-    socket.AF_INET, socket.SOCK_DGRAM)  # create UDP socket
-ack_sock.bind(("", ACK_PORT))  # bind to all interfaces on port 3333
-ack_sock.settimeout(0.5)  # timeout after 0.5 seconds if no data
+# Retransmit timeout per device, RFC 6298 style but with LAN-sized bounds instead of its 1 s minimum
+RTO_INITIAL_S = 0.2  # until a round trip has been measured
+RTO_MIN_S = 0.01
+RTO_MAX_S = 1.0
+MAX_RETRANSMITS = 5
+
+
+def histogram_percentile(buckets, p):
+    """Upper bound in us of the log2 bucket the nearest-rank percentile falls in"""
+    rank = p / 100 * sum(buckets)
+    seen = 0
+    for i, count in enumerate(buckets):
+        seen += count
+        if count and seen >= rank:
+            return 2 << i
+    return 0
+
+
+class TelemetryAggregator:
+    """Fleet view of the device telemetry reports: the latest report of every device, and the
+    command latency histograms merged since the last summary"""
+
+    def __init__(self):
+        self.latest = {}     # device id -> payload of its last report
+        self.last_seq = {}   # device id -> seq of its last report
+        self.buckets = [0] * 16
+        self.max_us = 0
+        self.reports = 0
+        self.lost = 0        # reports missing from the seq sequence
+
+    def add(self, msg):
+        report = msg["telemetry"]
+        if report is None:
+            return
+        last = self.last_seq.get(msg["id"])
+        if last is not None and msg["seq"] > last:
+            self.lost += msg["seq"] - last - 1  # a lower seq means the device rebooted
+        self.last_seq[msg["id"]] = msg["seq"]
+        self.latest[msg["id"]] = report
+        self.buckets = [a + b for a, b in zip(self.buckets, report["latency"]["buckets"])]
+        self.max_us = max(self.max_us, report["latency"]["max_us"])
+        self.reports += 1
+
+    def print_summary(self):
+        if not self.latest:
+            print("[TELEMETRY] No reports")
+            return
+        latest = self.latest
+        line = f"[TELEMETRY] {len(latest)} devices, {self.reports} reports, {self.lost} lost"
+        heap = {dev: r["heap_min_free"] for dev, r in latest.items() if r["heap_min_free"]}  # 0 on linux
+        if heap:
+            heap_id = min(heap, key=heap.get)
+            line += f", lowest heap {heap[heap_id]} B ({heap_id})"
+        rssi = [r["rssi"] for r in latest.values() if r["rssi"]]
+        if rssi:
+            line += f", RSSI dBm min {min(r[0] for r in rssi)} median {percentile([r[1] for r in rssi], 50)}"
+        for core in range(2):
+            loads = [r["cpu"][core] for r in latest.values() if r["cpu"][core] is not None]
+            if loads:
+                line += f", core {core} load % median {percentile(loads, 50)} max {max(loads)}"
+        print(line)
+        if sum(self.buckets):
+            print(f"[TELEMETRY] {sum(self.buckets)} commands, latency us: p50 < {histogram_percentile(self.buckets, 50)} "
+                  f"p99 < {histogram_percentile(self.buckets, 99)} max {self.max_us}")
+        stacks = {}
+        for device_id, report in latest.items():
+            for name, free in report["stacks"].items():
+                if name not in stacks or free < stacks[name][0]:
+                    stacks[name] = (free, device_id)
+        if stacks:
+            print("[TELEMETRY] lowest free stack B: " +
+                  ", ".join(f"{name} {free} ({dev})" for name, (free, dev) in sorted(stacks.items())))
+        self.buckets = [0] * 16
+        self.max_us = 0
+        self.reports = 0
+        self.lost = 0
+
+
+class Peer:
+    """What the coordinator knows about a device: the address it sends from and its round trip"""
+
+    def __init__(self):
+        self.addr = None  # set once the device announced itself or replied, it's registered then
+        self.last_seen = None
+        self.srtt = None
+        self.rttvar = None
+
+    def add_rtt(self, rtt):
+        if self.srtt is None:
+            self.srtt, self.rttvar = rtt, rtt / 2
+        else:
+            self.rttvar = 0.75 * self.rttvar + 0.25 * abs(self.srtt - rtt)
+            self.srtt = 0.875 * self.srtt + 0.125 * rtt
+
+    def rto(self):
+        if self.srtt is None:
+            return RTO_INITIAL_S
+        return min(RTO_MAX_S, max(RTO_MIN_S, self.srtt + 4 * self.rttvar))
+
+
+class Coordinator(asyncio.DatagramProtocol):
+    """One UDP endpoint on ACK_PORT shared by every session. It sends the commands, answers the
+    clock sync exchange, and hands ACKs and reports to the session waiting for them"""
+
+    def __init__(self, target_ip, ports, wire_format, verbose, boot_log=None, capture=None):
+        self.target_ip = target_ip
+        self.ports = ports
+        self.format = wire_format
+        self.verbose = verbose
+        self.transport = None
+        self.peers = {}       # device id -> Peer, the registry
+        self.sessions = {}    # session id -> Session
+        self.acks = {}        # (session, seq, device id) -> future, set to the ACK receive time
+        self.first_acks = {}  # (session, seq) -> future, set on the first ACK of the command
+        self.broadcasts = set()  # (session, seq) with a broadcast retransmit queued
+        self.sync_sent = None    # (seq, t1) of the last SYNC
+        self.time_replies = None  # (message, receive time) while the clock error is measured
+        self.stats_replies = None  # (address, message) while the stats are queried
+        self.boot_log = boot_log  # file the boot timelines are appended to, one JSON line each
+        self.telemetry = TelemetryAggregator()
+        self.capture = capture    # CaptureLog of every datagram sent and received
+        self.received = 0     # datagrams handled
+        self.retransmits = 0
+
+    def connection_made(self, transport):
+        self.transport = CapturingTransport(transport, self.capture) if self.capture else transport
+
+    def peer(self, device_id):
+        if device_id not in self.peers:
+            self.peers[device_id] = Peer()
+        return self.peers[device_id]
+
+    def registered(self):
+        """Ids of the devices whose address is known"""
+        return sorted(dev for dev, peer in self.peers.items() if peer.addr)
+
+    def register(self, device_id, addr):
+        peer = self.peer(device_id)
+        if peer.addr != addr and self.verbose:
+            print(f"[REGISTRY] {device_id} at {addr}")
+        peer.addr = addr
+        peer.last_seen = time.monotonic()
+
+    def rto_of(self, device_id):
+        """Retransmit timeout of a device. One that hasn't been measured yet gets the longest timeout
+        of the measured ones, the devices share the network"""
+        if self.peer(device_id).srtt is not None:
+            return self.peer(device_id).rto()
+        return max((p.rto() for p in self.peers.values() if p.srtt is not None), default=RTO_INITIAL_S)
+
+    def send_all(self, data):
+        """Send one datagram to every device port"""
+        for port in self.ports:
+            self.transport.sendto(data, (self.target_ip, port))
+
+    def send_group(self, ids, data):
+        """Send to the devices of ids only, by unicast, if they are a subset of the known devices and
+        all their addresses are known. Otherwise to every device"""
+        if len(ids) < len(self.registered()) and all(self.peer(dev).addr for dev in ids):
+            for device_id in ids:
+                self.transport.sendto(data, self.peer(device_id).addr)
+        else:
+            self.send_all(data)
+
+    def broadcast_soon(self, key, make_data):
+        """Queue one broadcast retransmit, shared by every device of key whose address is unknown"""
+        if key not in self.broadcasts:
+            self.broadcasts.add(key)
+            asyncio.get_running_loop().call_soon(self._broadcast, key, make_data)
+
+    def _broadcast(self, key, make_data):
+        self.broadcasts.discard(key)
+        self.send_all(make_data())
+
+    def datagram_received(self, data, addr):
+        t_rx = time.monotonic()
+        self.received += 1
+        if self.capture:
+            self.capture.write(CAPTURE_FROM_DEVICE, addr, data)
+        try:
+            msg = decode_message(data)
+        except ValueError:
+            return  # not a frame or JSON we understand
+        if not isinstance(msg, dict):
+            return
+        cmd = msg.get("cmd") or msg.get("status")  # JSON ACKs only carry a status
+        if cmd == "ack":
+            self.on_ack(msg, addr, t_rx)
+        elif cmd == "announce":
+            self.register(msg["id"], addr)
+        elif cmd == "boot":
+            self.on_boot(msg, addr)
+        elif cmd == "telemetry":
+            self.register(msg["id"], addr)
+            self.telemetry.add(msg)
+            if self.verbose:
+                print(f"[TELEMETRY] From {msg['id']}: {msg['telemetry']}")
+        elif cmd == "delay_req":
+            self.on_delay_req(msg, addr, t_rx)
+        elif cmd == "time_reply" and self.time_replies is not None:
+            self.time_replies.append((msg, now_us()))
+        elif cmd == "report" and msg["session"] in self.sessions:
+            self.sessions[msg["session"]].on_report(msg)
+        elif "packets" in msg and self.stats_replies is not None:
+            self.stats_replies.append((addr, msg))
+
+    def on_ack(self, msg, addr, t_rx):
+        key = (msg.get("session"), msg.get("seq"))
+        ack = self.acks.get(key + (msg.get("id"),))
+        if ack is None or ack.done():
+            return  # late, duplicate or someone else's ACK
+        self.register(msg["id"], addr)
+        ack.set_result(t_rx)
+        if not self.first_acks[key].done():
+            self.first_acks[key].set_result(None)
+        if self.verbose:
+            print(f"[ACK] From {addr}: {msg}")
+
+    def on_delay_req(self, msg, addr, t_rx):
+        """Answer a DELAY_REQ with its receive time t4, see main/clock_sync.h"""
+        t4 = int(t_rx * 1e6)  # same clock as now_us()
+        if self.sync_sent is None or msg["seq"] != self.sync_sent[0]:
+            return
+        self.transport.sendto(encode_frame(CMD_DELAY_RESP, msg["seq"], 0, device_id=msg["id"],
+                                           timestamp_us=t4), addr)
+        self.register(msg["id"], addr)
+        self.peer(msg["id"]).add_rtt((t4 - self.sync_sent[1]) / 1e6)
 
-received_acks = set()
-start_time = time.time()
+    def on_boot(self, msg, addr):
+        """A device sends its boot timeline when it has booted, and when asked for it"""
+        self.register(msg["id"], addr)
+        phases = sorted(msg["phases_us"].items(), key=lambda phase: phase[1])
+        note = f", {msg['note']}" if msg.get("note") else ""
+        print(f"[BOOT] {msg['id']} firmware {msg['fw']}{note}: "
+              + " ".join(f"{name} {t_us / 1000:.0f}" for name, t_us in phases) + " ms")
+        if self.boot_log:
+            with open(self.boot_log, "a") as log:
+                log.write(json.dumps(dict(msg, received=time.time())) + "\n")
+
+    async def query_boot(self, wait_s=0.5):
+        """Every device replies to the sender with its boot timeline"""
+        self.send_all(json.dumps({"cmd": "boot"}).encode())
+        await asyncio.sleep(wait_s)
+
+    async def discover(self, wait_s=0.3):
+        """Ask every device to announce itself, the registry also keeps the devices that announced
+        on their own"""
+        self.send_all(encode_frame(CMD_DISCOVER))
+        await asyncio.sleep(wait_s)
+        print(f"[REGISTRY] {len(self.registered())} devices registered")
+
+    async def sync_clocks(self, rounds, interval_s=0.05):
+        """Act as the time master: broadcast SYNC(t1), every DELAY_REQ is answered on receipt"""
+        for seq in range(rounds):
+            self.sync_sent = (seq, now_us())
+            self.send_all(encode_frame(CMD_SYNC, seq, 0, timestamp_us=self.sync_sent[1]))
+            await asyncio.sleep(interval_s)
+        self.sync_sent = None
+
+    async def report_clock_error(self, wait_s=0.2):
+        """Ask every device for its estimate of the server clock and compare it with the
+        server clock halfway through the round trip"""
+        t_query = now_us()
+        self.time_replies = []
+        self.send_all(encode_frame(CMD_TIME_QUERY, 0, 0, timestamp_us=t_query))
+        await asyncio.sleep(wait_s)
+        errors = []
+        for msg, t_reply in self.time_replies:
+            error_us = msg["timestamp_us"] - (t_query + t_reply) // 2
+            errors.append(abs(error_us))
+            if self.verbose:
+                print(f"[SYNC] {msg['id']}: offset error {error_us / 1000:+.3f} ms "
+                      f"(+/- {(t_reply - t_query) / 2000:.3f} ms)")
+        self.time_replies = None
+        if errors:
+            print(f"[SYNC] {len(errors)} devices, offset error ms: median {percentile(errors, 50) / 1000:.3f} "
+                  f"max {max(errors) / 1000:.3f}")
+
+    async def query_stats(self, wait_s=0.5):
+        """Every device replies to the sender with its counters"""
+        self.stats_replies = []
+        self.send_all(json.dumps({"cmd": "stats"}).encode())
+        await asyncio.sleep(wait_s)
+        for addr, msg in self.stats_replies:
+            print(f"[STATS] From {addr}: {msg}")
+        self.stats_replies = None
+
+    async def deliver(self, key, device_id, ack, make_data, t_sent, give_up_at):
+        """Wait for the ACK of one device, retransmitting after its timeout, doubled every time.
+        Returns the ACK receive time, None if it didn't come by give_up_at or after MAX_RETRANSMITS"""
+        first_ack = self.first_acks[key]
+        retransmits, last_sent = 0, t_sent
+        while True:
+            deadline = min(last_sent + self.rto_of(device_id) * 2 ** retransmits, give_up_at)
+            # an unmeasured device's timeout shrinks with the first ACK, wake up to recompute it
+            waits = {ack} if first_ack.done() else {ack, first_ack}
+            await asyncio.wait(waits, timeout=max(0.0, deadline - time.monotonic()))
+            if ack.done():
+                if retransmits == 0:
+                    self.peer(device_id).add_rtt(ack.result() - t_sent)  # Karn: not after a retransmit
+                return ack.result()
+            now = time.monotonic()
+            if now < deadline:
+                continue
+            if now >= give_up_at or retransmits == MAX_RETRANSMITS:
+                return None
+            retransmits += 1
+            self.retransmits += 1
+            last_sent = now
+            if self.peer(device_id).addr:
+                self.transport.sendto(make_data(), self.peer(device_id).addr)
+            else:
+                self.broadcast_soon(key, make_data)
+            if self.verbose:
+                print(f"[RETRY] session {key[0]} seq {key[1]} to {device_id}, attempt {retransmits}")
+
+    async def send_reliable(self, session_id, seq, make_data, ids, give_up_at):
+        """Send command seq to the devices of ids and retransmit it to each one until it ACKs.
+        make_data() builds the datagram, it's called again for every retransmit.
+        Returns {device id: ACK latency in s, None if it never ACKed}"""
+        key = (session_id, seq)
+        loop = asyncio.get_running_loop()
+        self.first_acks[key] = loop.create_future()
+        acks = {dev: loop.create_future() for dev in ids}
+        for device_id, ack in acks.items():
+            self.acks[key + (device_id,)] = ack
+        t_sent = time.monotonic()
+        self.send_group(ids, make_data())
+        try:
+            results = await asyncio.gather(*(self.deliver(key, dev, ack, make_data, t_sent, give_up_at)
+                                             for dev, ack in acks.items()))
+        finally:
+            for device_id in ids:
+                del self.acks[key + (device_id,)]
+            del self.first_acks[key]
+        return {dev: None if t is None else t - t_sent for dev, t in zip(ids, results)}
+
+
+class Session:
+    """Start, and stop if a device is missing, one session on a group of devices"""
+
+    def __init__(self, coordinator, ids, delay_ms, synced):
+        self.coordinator = coordinator
+        self.ids = ids
+        self.delay_ms = delay_ms
+        self.synced = synced
+        self.id = random.getrandbits(32)  # new every time, devices drop a (session, seq) they already saw
+        self.start_at_us = 0
+        self.latencies = {}  # device id -> start ACK latency in s, None if it never ACKed
+        self.reports = {}
+
+    def make_start(self):
+        """Start command, seq 0. A retransmit names the same start time: the same ref_us, or the
+        time left until it in delay_ms"""
+        delay = max(0, (self.start_at_us - now_us()) // 1000)
+        if self.coordinator.format == "binary":
+            return encode_frame(CMD_START, 0, self.id, delay, ref_us=self.start_at_us if self.synced else 0)
+        return json.dumps({"cmd": "start", "seq": 0, "delay_ms": delay, "session": self.id}).encode('utf-8')
+
+    def make_stop(self):
+        """Stop command, seq 1"""
+        if self.coordinator.format == "binary":
+            return encode_frame(CMD_STOP, 1, self.id)
+        return json.dumps({"cmd": "stop", "seq": 1, "reason": "missing_acks", "session": self.id}).encode()
+
+    def on_report(self, msg):
+        if msg["id"] in self.ids:
+            self.reports[msg["id"]] = msg
+
+    async def run(self):
+        self.coordinator.sessions[self.id] = self
+        try:
+            await self._run()
+        finally:
+            del self.coordinator.sessions[self.id]
+
+    async def _run(self):
+        tag = f"[SESSION {self.id}]"
+        t_start = time.monotonic()
+        self.start_at_us = now_us() + self.delay_ms * 1000
+        print(f"{tag} start sent to {len(self.ids)} devices")
+
+        # give up halfway to the start time, the other half is left to get the stop through
+        self.latencies = latencies = await self.coordinator.send_reliable(self.id, 0, self.make_start, self.ids,
+                                                                          t_start + self.delay_ms / 2000)
+        acked = [lat * 1000 for lat in latencies.values() if lat is not None]
+        if acked:
+            print(f"{tag} {len(acked)}/{len(self.ids)} ACKs, latency ms: p50 {percentile(acked, 50):.2f} "
+                  f"p90 {percentile(acked, 90):.2f} p99 {percentile(acked, 99):.2f} max {max(acked):.2f}")
+
+        missing = {dev for dev, lat in latencies.items() if lat is None}
+        if missing:
+            print(f"{tag} [WARN] Missing ACKs from: {sorted(missing)}")
+            # the missing devices too: a lost ACK doesn't mean the start was lost. send_reliable only
+            # retransmits to the devices that haven't ACKed the stop, by their last address or broadcast
+            stop_latencies = await self.coordinator.send_reliable(self.id, 1, self.make_stop, self.ids,
+                                                                  self.start_at_us / 1e6)
+            missing_stop = [dev for dev, lat in stop_latencies.items() if lat is None]
+            if missing_stop:
+                print(f"{tag} [WARN] Stop not ACKed by: {missing_stop}")
+            return
+        print(f"{tag} [OK] All ACKs received in {max(acked):.1f} ms")
+
+        # the devices report their actual start time once the session starts
+        if self.coordinator.format == "binary":
+            await asyncio.sleep(max(0.0, self.start_at_us / 1e6 + 1.0 - time.monotonic()))
+            self.print_reports(tag)
+
+    def print_reports(self, tag):
+        """Scheduling jitter distribution (actual minus target start time) and how far apart
+        the devices started"""
+        if not self.reports:
+            print(f"{tag} [WARN] No start reports received")
+            return
+        jitter = [m["timestamp_us"] - m["ref_us"] for m in self.reports.values()]
+        starts = [m["timestamp_us"] for m in self.reports.values()]
+        if self.coordinator.verbose:
+            for msg in self.reports.values():
+                print(f"[REPORT] {msg['id']}: started {msg['timestamp_us'] - msg['ref_us']:+d} us from target")
+        print(f"{tag} {len(self.reports)} reports, jitter us: min {min(jitter)} median {percentile(jitter, 50)} "
+              f"p90 {percentile(jitter, 90)} max {max(jitter)}, start spread {max(starts) - min(starts)} us")
+
+
+# Capture log of the session traffic, written by --capture and server/capture.py. After CAPTURE_MAGIC,
+# one record per datagram: monotonic time in ns, direction, IPv4 address and port of the device end
+# (0.0.0.0 for a command captured from a broadcast), datagram length, then the datagram itself.
+# Network byte order
+CAPTURE_MAGIC = b"UDPCAP1\n"
+CAPTURE_RECORD = struct.Struct("!QB4sHH")
+CAPTURE_TO_DEVICE, CAPTURE_FROM_DEVICE = 0, 1
+
+
+class CaptureLog:
+    """Writes a capture log"""
+
+    def __init__(self, path):
+        self.file = open(path, "wb")
+        self.file.write(CAPTURE_MAGIC)
+
+    def write(self, direction, addr, data, t_ns=None):
+        if t_ns is None:
+            t_ns = time.monotonic_ns()
+        ip = socket.inet_aton(socket.gethostbyname(addr[0]))
+        self.file.write(CAPTURE_RECORD.pack(t_ns, direction, ip, addr[1], len(data)) + data)
+
+    def close(self):
+        self.file.close()
+
+
+def read_capture(path):
+    """Records of a capture log, as (t_ns, direction, (ip, port), datagram)"""
+    with open(path, "rb") as f:
+        if f.read(len(CAPTURE_MAGIC)) != CAPTURE_MAGIC:
+            raise ValueError(f"{path} is not a capture log")
+        while len(header := f.read(CAPTURE_RECORD.size)) == CAPTURE_RECORD.size:
+            t_ns, direction, ip, port, length = CAPTURE_RECORD.unpack(header)
+            data = f.read(length)
+            if len(data) < length:
+                break  # cut off while it was written
+            yield t_ns, direction, (socket.inet_ntoa(ip), port), data
+
+
+class CapturingTransport:
+    """Datagram transport that logs everything sent through it"""
+
+    def __init__(self, transport, capture):
+        self.transport = transport
+        self.capture = capture
+
+    def sendto(self, data, addr):
+        self.capture.write(CAPTURE_TO_DEVICE, addr, data)
+        self.transport.sendto(data, addr)
+
+
+def open_socket(port, multicast_ttl=1, multicast_loop=False):
+    """UDP socket bound to port, able to send to broadcast and multicast addresses.
+    multicast_ttl 1 keeps the commands on the local network; multicast_loop also delivers
+    them to devices running on this host"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, multicast_ttl)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, int(multicast_loop))
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)  # a few hundred ACKs arrive at once
+    sock.bind(("", port))
+    return sock
+
+
+async def run(args):
+    if args.multicast:
+        target_ip = args.multicast
+        print(f"[INFO] Using multicast group: {target_ip}, TTL {args.ttl}")
+    else:
+        target_ip = args.ip or broadcast_address()
+        if args.ip:
+            print(f"[INFO] Using IP: {target_ip}")
+
+    # Bind the ACK port before sending, a device on the same host ACKs right away
+    sock = open_socket(ACK_PORT, args.ttl, args.multicast_loop)
+    capture = CaptureLog(args.capture) if args.capture else None
+    transport, coordinator = await asyncio.get_running_loop().create_datagram_endpoint(
+        lambda: Coordinator(target_ip, args.ports, args.format, args.verbose, args.boot_log, capture), sock=sock)
 
-print("[Server] Waiting for ACKs...")
-while time.time() - start_time < 0.5:
     try:
-        data, addr = ack_sock.recvfrom(1024)
-        # recvfrom: receive UDP packet and sender address, 1024 is the buffer size
-        message = json.loads(data.decode())
-        print(f"[ACK] From {addr}: {message}")
-        device_id = message.get("id")
-        if device_id:
-            received_acks.add(device_id)
-    except socket.timeout:
-        break  # exit loop if timeout
-
-
-# Check if all expected ACKs were received
-missing = EXPECTED_IDS - received_acks
-if missing:
-    print(f"[WARN] Missing ACKs from: {missing}")
-    stop_msg = {
-        "cmd": "stop",
-        "reason": "missing_acks",
-        "session": session_id
-    }
-    stop_data = json.dumps(stop_msg).encode()
-    stop_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-    stop_sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
-    stop_sock.sendto(stop_data, (BROADCAST_IP, START_PORT)
-                     )  # broadcast stop command
-else:
-    print("[OK] All ACKs received.")
-
-# Close sockets to release resources
-broadcast_sock.close()
-ack_sock.close()
+        if args.stats:
+            await coordinator.query_stats()
+            return
+        if args.boot:
+            await coordinator.query_boot()
+            return
+        if args.telemetry:
+            # the devices send their reports on their own, print the fleet view until interrupted
+            while True:
+                await asyncio.sleep(args.telemetry)
+                coordinator.telemetry.print_summary()
+
+        # The registered devices are the ones the sessions expect, unless --ids names them. A named
+        # device that isn't registered can't be reached, no point in waiting for its ACK
+        await coordinator.discover()
+        ids = args.ids or coordinator.registered()
+        unregistered = [dev for dev in ids if not coordinator.peer(dev).addr]
+        if unregistered:
+            print(f"[ERROR] Not registered: {unregistered}, no session started")
+            return
+        if not ids:
+            print("[ERROR] No devices registered, no session started")
+            return
+
+        # Synchronize the device clocks, so the start can name an absolute time
+        synced = False
+        if args.format == "binary" and args.sync_rounds > 0:
+            await coordinator.sync_clocks(args.sync_rounds)
+            await coordinator.report_clock_error()
+            synced = True
+        print(f"[INFO] {len(ids)} devices, {args.sessions} sessions")
+
+        # Split the devices over the sessions, which run concurrently
+        sessions = [Session(coordinator, ids[i::args.sessions], args.delay_ms, synced)
+                    for i in range(args.sessions) if ids[i::args.sessions]]
+        await asyncio.gather(*(session.run() for session in sessions))
+    finally:
+        transport.close()
+        if capture:
+            capture.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Start a session on the devices")
+    parser.add_argument("--ip", help="send the commands to this address instead of the subnet broadcast, "
+                        "e.g. 127.0.0.1 for a linux-target device build")
+    parser.add_argument("--multicast", metavar="GROUP",
+                        help="send the commands to this multicast group instead, see UDP_CMD_MULTICAST_GROUP")
+    parser.add_argument("--ttl", type=int, default=1,
+                        help="multicast TTL, 1 keeps the commands on the local network")
+    parser.add_argument("--multicast-loop", action="store_true",
+                        help="deliver multicast commands to devices on this host too")
+    parser.add_argument("--stats", action="store_true",
+                        help="only query and print the command service latency counters")
+    parser.add_argument("--boot", action="store_true",
+                        help="only query and print the boot timeline of every device")
+    parser.add_argument("--boot-log", metavar="FILE",
+                        help="append every boot timeline received to FILE, one JSON object per line")
+    parser.add_argument("--telemetry", type=float, metavar="S",
+                        help="only collect the device telemetry and print a fleet summary every S seconds")
+    parser.add_argument("--capture", metavar="FILE",
+                        help="log every datagram sent and received to FILE, for server/capture.py")
+    parser.add_argument("--format", choices=["binary", "json"], default="binary",
+                        help="wire format of the commands, devices reply in the same format")
+    parser.add_argument("--bench", action="store_true",
+                        help="only benchmark the JSON and binary codecs")
+    parser.add_argument("--ports", type=int, nargs="+", default=[12345],
+                        help="device command ports, e.g. several linux-target devices on one host")
+    parser.add_argument("--sync-rounds", type=int, default=8,
+                        help="clock synchronization rounds before the session starts (binary format only), "
+                        "0 to rely on delay_ms alone")
+    parser.add_argument("--delay-ms", type=int, default=10000,
+                        help="time from the first start command to the session start")
+    parser.add_argument("--ids", nargs="+",
+                        help="device ids that have to ACK the start, by default every registered device")
+    parser.add_argument("--sessions", type=int, default=1,
+                        help="split the devices into this many concurrent sessions")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="print every ACK, retransmit and per-device result")
+    args = parser.parse_args()
+
+    if args.bench:
+        run_codec_benchmark()
+        return
+
+    try:
+        asyncio.run(run(args))
+    except KeyboardInterrupt:
+        pass  # the way out of --telemetry
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,566 @@
+// Fleet simulator: many virtual devices in one host process, speaking the device's start/ACK protocol
+// with the device's own frame codec, JSON parser and retransmit rules, to load-test server/server.py.
+//
+// Every device has its own socket on SIM_BASE_PORT + i and answers the way the command service does:
+// start/stop are deduplicated and ACKed, SYNC is answered with a DELAY_REQ, TIME_QUERY with the device
+// clock, DISCOVER with an ANNOUNCE, and a REPORT is sent once a session starts. Replies go to the
+// command's sender, and every device announces itself to SIM_SERVER_IP at start. All devices share the
+// host's monotonic clock, the same one server.py uses, so the clock estimate is exact and the
+// DELAY_RESP is ignored.
+//
+// Answers are delayed by SIM_PROC_DELAY_US plus up to SIM_JITTER_US, and any datagram, in or out, is
+// dropped with a probability of SIM_LOSS_PERMILLE / 1000. The settings can be overridden with
+// environment variables of the same name (SIM_DEVICES, SIM_BASE_PORT, ...), plus SIM_SEED.
+
+#define _GNU_SOURCE // ppoll
+#include "sdkconfig.h"
+#include "cmd_proto.h"
+#include "cmd_json.h"
+#include "cmd_dedup.h"
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MAX_EVENTS 16384    // queued answers and session starts, for all devices together
+#define SIM_MAX_DATAGRAM 128    // longest answer, the stats reply
+#define SIM_STATS_INTERVAL_US (5 * 1000000LL)
+
+typedef struct
+{
+    char id[CMD_PROTO_ID_LEN + 1];
+    int sock;
+    cmd_dedup_t seen;
+    cmd_dedup_start_t pending; // valid while a session start is pending
+    cmd_dedup_start_t fired;   // the last session that started
+    struct sockaddr_in report_addr; // sender of the start that armed it
+} sim_device_t;
+
+typedef enum
+{
+    SIM_EVENT_SEND,  // send data to dest
+    SIM_EVENT_START, // the session armed by seq starts
+} sim_event_kind_t;
+
+typedef struct
+{
+    int64_t due_us;
+    int device;
+    sim_event_kind_t kind;
+    struct sockaddr_in dest;
+    uint32_t session; // SIM_EVENT_START only
+    uint32_t seq;
+    int64_t target_us;
+    uint16_t len;
+    uint8_t data[SIM_MAX_DATAGRAM];
+} sim_event_t;
+
+static struct
+{
+    int devices;
+    int base_port;
+    const char *server_ip;
+    int ack_port;
+    int proc_delay_us;
+    int jitter_us;
+    int loss_permille;
+    unsigned seed;
+} s_config = {
+    .devices = CONFIG_SIM_DEVICES,
+    .base_port = CONFIG_SIM_BASE_PORT,
+    .server_ip = CONFIG_SIM_SERVER_IP,
+    .ack_port = CONFIG_SIM_ACK_PORT,
+    .proc_delay_us = CONFIG_SIM_PROC_DELAY_US,
+    .jitter_us = CONFIG_SIM_JITTER_US,
+    .loss_permille = CONFIG_SIM_LOSS_PERMILLE,
+    .seed = 1,
+};
+
+static sim_device_t *s_devices;
+static struct pollfd *s_fds;
+static struct sockaddr_in s_server_addr; // where the devices announce themselves
+static uint64_t s_rng;
+
+// Min-heap on due_us
+static sim_event_t s_events[SIM_MAX_EVENTS];
+static int s_event_count;
+
+static struct
+{
+    uint32_t received;
+    uint32_t sent;
+    uint32_t dropped; // by the simulated loss
+    uint32_t overflow; // answers lost because the event queue was full
+    uint32_t duplicates;
+    uint32_t started;
+} s_stats;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts); // time.monotonic() in server.py
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// xorshift64, reproducible with SIM_SEED
+static uint32_t next_random(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+static int lost(void)
+{
+    return s_config.loss_permille > 0 && (int)(next_random() % 1000) < s_config.loss_permille;
+}
+
+static int64_t answer_time(int64_t rx_us)
+{
+    return rx_us + s_config.proc_delay_us + (s_config.jitter_us ? next_random() % (s_config.jitter_us + 1) : 0);
+}
+
+static void swap_events(int a, int b)
+{
+    sim_event_t tmp = s_events[a];
+    s_events[a] = s_events[b];
+    s_events[b] = tmp;
+}
+
+static sim_event_t *push_event(int64_t due_us, int device, sim_event_kind_t kind)
+{
+    if (s_event_count == SIM_MAX_EVENTS)
+    {
+        s_stats.overflow++;
+        return NULL;
+    }
+    int i = s_event_count++;
+    s_events[i].due_us = due_us;
+    s_events[i].device = device;
+    s_events[i].kind = kind;
+    while (i > 0 && s_events[(i - 1) / 2].due_us > s_events[i].due_us)
+    {
+        swap_events(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    return &s_events[i];
+}
+
+static void pop_event(sim_event_t *event)
+{
+    *event = s_events[0];
+    s_events[0] = s_events[--s_event_count];
+    int i = 0;
+    while (1)
+    {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < s_event_count && s_events[left].due_us < s_events[smallest].due_us)
+        {
+            smallest = left;
+        }
+        if (right < s_event_count && s_events[right].due_us < s_events[smallest].due_us)
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+        {
+            break;
+        }
+        swap_events(i, smallest);
+        i = smallest;
+    }
+}
+
+// Queue a datagram from device to dest, sent once the processing delay is over
+static void queue_send(int device, int64_t rx_us, const void *data, size_t len, const struct sockaddr_in *dest)
+{
+    if (len > SIM_MAX_DATAGRAM)
+    {
+        return;
+    }
+    sim_event_t *event = push_event(answer_time(rx_us), device, SIM_EVENT_SEND);
+    if (event != NULL)
+    {
+        event->dest = *dest;
+        event->len = len;
+        memcpy(event->data, data, len);
+    }
+}
+
+// Queue a binary frame, the device id and version are filled in like send_frame() on the device
+static void queue_frame(int device, int64_t rx_us, uint8_t version, cmd_msg_t *msg, const struct sockaddr_in *dest)
+{
+    uint8_t frame[CMD_PROTO_FRAME_SIZE];
+    msg->version = version;
+    memcpy(msg->device_id, s_devices[device].id, sizeof(msg->device_id));
+    size_t len = cmd_proto_encode(msg, frame, sizeof(frame));
+    queue_send(device, rx_us, frame, len, dest);
+}
+
+static int check_seen(sim_device_t *dev, const cmd_msg_t *msg)
+{
+    if (!cmd_dedup_check(&dev->seen, msg))
+    {
+        return 0;
+    }
+    s_stats.duplicates++;
+    return 1;
+}
+
+static void queue_ack(int device, int64_t rx_us, int binary, const cmd_msg_t *msg, const struct sockaddr_in *source)
+{
+    if (binary)
+    {
+        cmd_msg_t ack = cmd_proto_reply(msg, CMD_PROTO_CMD_ACK);
+        queue_frame(device, rx_us, ack.version, &ack, source);
+    }
+    else
+    {
+        char ack_msg[CMD_JSON_ACK_MAX];
+        int len = cmd_json_format_ack(ack_msg, sizeof(ack_msg), s_devices[device].id, msg);
+        queue_send(device, rx_us, ack_msg, len, source);
+    }
+}
+
+static void handle_start(int device, int64_t rx_us, int binary, const cmd_msg_t *msg, const struct sockaddr_in *source)
+{
+    sim_device_t *dev = &s_devices[device];
+    if (!check_seen(dev, msg))
+    {
+        // the server clock is the host clock, ref_us needs no conversion
+        int64_t target_us = msg->ref_us != 0 ? msg->ref_us : rx_us + (int64_t)msg->delay_ms * 1000;
+        if (!cmd_dedup_start_ignored(&dev->pending, &dev->fired, msg->session, msg->seq, target_us))
+        {
+            dev->pending = (cmd_dedup_start_t){1, msg->session, msg->seq, target_us};
+            dev->report_addr = *source;
+            sim_event_t *event = push_event(target_us, device, SIM_EVENT_START);
+            if (event != NULL)
+            {
+                event->session = msg->session;
+                event->seq = msg->seq;
+                event->target_us = target_us;
+            }
+        }
+    }
+    queue_ack(device, rx_us, binary, msg, source);
+}
+
+static void handle_stop(int device, int64_t rx_us, int binary, const cmd_msg_t *msg, const struct sockaddr_in *source)
+{
+    sim_device_t *dev = &s_devices[device];
+    if (!check_seen(dev, msg) && dev->pending.valid && dev->pending.session == msg->session)
+    {
+        dev->pending.valid = 0;
+    }
+    queue_ack(device, rx_us, binary, msg, source);
+}
+
+static void handle_datagram(int device, const char *buf, int len, const struct sockaddr_in *source, int64_t rx_us)
+{
+    cmd_msg_t msg;
+    if (cmd_proto_is_frame((const uint8_t *)buf, len))
+    {
+        if (cmd_proto_decode((const uint8_t *)buf, len, &msg) != 0)
+        {
+            return;
+        }
+        uint8_t version = cmd_proto_reply_version(msg.version);
+        switch (msg.cmd)
+        {
+        case CMD_PROTO_CMD_START:
+            handle_start(device, rx_us, 1, &msg, source);
+            break;
+        case CMD_PROTO_CMD_STOP:
+            handle_stop(device, rx_us, 1, &msg, source);
+            break;
+        case CMD_PROTO_CMD_SYNC:
+        {
+            cmd_msg_t delay_req = cmd_proto_reply(&msg, CMD_PROTO_CMD_DELAY_REQ);
+            queue_frame(device, rx_us, version, &delay_req, source); // stamped when it's sent
+            break;
+        }
+        case CMD_PROTO_CMD_TIME_QUERY:
+        {
+            cmd_msg_t reply = cmd_proto_reply(&msg, CMD_PROTO_CMD_TIME_REPLY);
+            reply.timestamp_us = rx_us;
+            queue_frame(device, rx_us, version, &reply, source);
+            break;
+        }
+        case CMD_PROTO_CMD_DISCOVER:
+        {
+            cmd_msg_t announce = {.cmd = CMD_PROTO_CMD_ANNOUNCE, .seq = 1};
+            queue_frame(device, rx_us, version, &announce, source);
+            break;
+        }
+        default:
+            break; // DELAY_RESP: the clocks are the same
+        }
+        return;
+    }
+
+    char name[CMD_JSON_NAME_MAX];
+    if (cmd_json_parse(buf, len, name, sizeof(name), &msg) != 0)
+    {
+        return;
+    }
+    msg.version = 0;
+    if (strcmp(name, "start") == 0)
+    {
+        msg.cmd = CMD_PROTO_CMD_START;
+        handle_start(device, rx_us, 0, &msg, source);
+    }
+    else if (strcmp(name, "stop") == 0)
+    {
+        msg.cmd = CMD_PROTO_CMD_STOP;
+        handle_stop(device, rx_us, 0, &msg, source);
+    }
+    else if (strcmp(name, "stats") == 0)
+    {
+        char reply[SIM_MAX_DATAGRAM];
+        int reply_len = snprintf(reply, sizeof(reply), "{\"id\":\"%s\",\"packets\":%lu,\"duplicates\":%lu}",
+                                 s_devices[device].id, (unsigned long)s_stats.received, (unsigned long)s_stats.duplicates);
+        queue_send(device, rx_us, reply, reply_len, source);
+    }
+}
+
+static void run_event(const sim_event_t *event)
+{
+    sim_device_t *dev = &s_devices[event->device];
+    if (event->kind == SIM_EVENT_START)
+    {
+        // superseded or stopped since it was queued
+        if (!dev->pending.valid || dev->pending.session != event->session || dev->pending.seq != event->seq)
+        {
+            return;
+        }
+        int64_t fired_us = now_us();
+        dev->fired = dev->pending;
+        dev->pending.valid = 0;
+        s_stats.started++;
+        cmd_msg_t report = {
+            .version = CMD_PROTO_VERSION,
+            .cmd = CMD_PROTO_CMD_REPORT,
+            .seq = event->seq,
+            .session = event->session,
+            .timestamp_us = fired_us,
+            .ref_us = event->target_us,
+        };
+        memcpy(report.device_id, dev->id, sizeof(report.device_id));
+        uint8_t frame[CMD_PROTO_FRAME_SIZE];
+        size_t len = cmd_proto_encode(&report, frame, sizeof(frame));
+        if (lost())
+        {
+            s_stats.dropped++;
+            return;
+        }
+        sendto(dev->sock, frame, len, 0, (const struct sockaddr *)&dev->report_addr, sizeof(dev->report_addr));
+        s_stats.sent++;
+        return;
+    }
+
+    if (lost())
+    {
+        s_stats.dropped++;
+        return;
+    }
+    uint8_t data[SIM_MAX_DATAGRAM];
+    memcpy(data, event->data, event->len);
+    if (event->len >= CMD_PROTO_FRAME_SIZE_V1 && cmd_proto_is_frame(data, event->len))
+    {
+        // stamp the frame when it's actually sent, as send_frame() does, for the clock sync
+        int64_t t = now_us();
+        cmd_msg_t msg;
+        if (cmd_proto_decode(data, event->len, &msg) == 0 && msg.timestamp_us == 0)
+        {
+            msg.timestamp_us = t;
+            cmd_proto_encode(&msg, data, sizeof(data));
+        }
+    }
+    sendto(dev->sock, data, event->len, 0, (const struct sockaddr *)&event->dest, sizeof(event->dest));
+    s_stats.sent++;
+}
+
+static void apply_env(const char *name, int *value)
+{
+    if (getenv(name))
+    {
+        *value = atoi(getenv(name));
+    }
+}
+
+static int open_devices(void)
+{
+    // one socket per device, more than the default descriptor limit from about a thousand on
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)s_config.devices + 64)
+    {
+        limit.rlim_cur = limit.rlim_max < (rlim_t)s_config.devices + 64 ? limit.rlim_max : (rlim_t)s_config.devices + 64;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    s_devices = calloc(s_config.devices, sizeof(*s_devices));
+    s_fds = calloc(s_config.devices, sizeof(*s_fds));
+    if (s_devices == NULL || s_fds == NULL)
+    {
+        printf("Out of memory for %d devices\n", s_config.devices);
+        return -1;
+    }
+
+    for (int i = 0; i < s_config.devices; i++)
+    {
+        sim_device_t *dev = &s_devices[i];
+        snprintf(dev->id, sizeof(dev->id), "SIM_%04d", i % 10000);
+        dev->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (dev->sock < 0)
+        {
+            perror("socket failed");
+            return -1;
+        }
+        int broadcast = 1;
+        setsockopt(dev->sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+        struct sockaddr_in listen_addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(s_config.base_port + i),
+            .sin_addr.s_addr = htonl(INADDR_ANY),
+        };
+        if (bind(dev->sock, (struct sockaddr *)&listen_addr, sizeof(listen_addr)) < 0)
+        {
+            printf("bind failed on port %d: %s\n", s_config.base_port + i, strerror(errno));
+            return -1;
+        }
+        s_fds[i].fd = dev->sock;
+        s_fds[i].events = POLLIN;
+    }
+    return 0;
+}
+
+void app_main(void)
+{
+    apply_env("SIM_DEVICES", &s_config.devices);
+    apply_env("SIM_BASE_PORT", &s_config.base_port);
+    apply_env("SIM_ACK_PORT", &s_config.ack_port);
+    apply_env("SIM_PROC_DELAY_US", &s_config.proc_delay_us);
+    apply_env("SIM_JITTER_US", &s_config.jitter_us);
+    apply_env("SIM_LOSS_PERMILLE", &s_config.loss_permille);
+    if (getenv("SIM_SERVER_IP"))
+    {
+        s_config.server_ip = getenv("SIM_SERVER_IP");
+    }
+    if (getenv("SIM_SEED"))
+    {
+        s_config.seed = strtoul(getenv("SIM_SEED"), NULL, 10);
+    }
+    s_rng = ((uint64_t)s_config.seed << 1) | 1; // xorshift state must not be 0
+
+    s_server_addr.sin_family = AF_INET;
+    s_server_addr.sin_port = htons(s_config.ack_port);
+    if (inet_pton(AF_INET, s_config.server_ip, &s_server_addr.sin_addr) != 1)
+    {
+        printf("Invalid server IP: %s\n", s_config.server_ip);
+        return;
+    }
+    if (s_config.devices < 1 || s_config.devices > 9999)
+    {
+        printf("SIM_DEVICES must be between 1 and 9999\n");
+        return;
+    }
+    if (open_devices() != 0)
+    {
+        return;
+    }
+    printf("Fleet simulator: %d devices on ports %d-%d, delay %d us, jitter %d us, loss %d permille\n",
+           s_config.devices, s_config.base_port, s_config.base_port + s_config.devices - 1,
+           s_config.proc_delay_us, s_config.jitter_us, s_config.loss_permille);
+    fflush(stdout);
+
+    // boot announcement, seq 0
+    for (int i = 0; i < s_config.devices; i++)
+    {
+        cmd_msg_t announce = {.cmd = CMD_PROTO_CMD_ANNOUNCE};
+        queue_frame(i, now_us(), CMD_PROTO_VERSION, &announce, &s_server_addr);
+    }
+
+    char rx_buffer[256];
+    int64_t next_stats_us = now_us() + SIM_STATS_INTERVAL_US;
+    uint32_t last_received = 0;
+    while (1)
+    {
+        int64_t now = now_us();
+        while (s_event_count > 0 && s_events[0].due_us <= now)
+        {
+            sim_event_t event;
+            pop_event(&event);
+            run_event(&event);
+        }
+        if (now >= next_stats_us)
+        {
+            if (s_stats.received != last_received)
+            {
+                printf("received %lu sent %lu dropped %lu duplicates %lu started %lu overflow %lu\n",
+                       (unsigned long)s_stats.received, (unsigned long)s_stats.sent, (unsigned long)s_stats.dropped,
+                       (unsigned long)s_stats.duplicates, (unsigned long)s_stats.started, (unsigned long)s_stats.overflow);
+                fflush(stdout);
+                last_received = s_stats.received;
+            }
+            next_stats_us = now + SIM_STATS_INTERVAL_US;
+        }
+
+        int64_t wait_us = next_stats_us - now;
+        if (s_event_count > 0 && s_events[0].due_us - now < wait_us)
+        {
+            wait_us = s_events[0].due_us - now;
+        }
+        // ppoll() rather than poll(), a ms timeout would delay the answers by up to a ms
+        struct timespec timeout = {.tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000};
+        int ready = ppoll(s_fds, s_config.devices, &timeout, NULL);
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+            {
+                perror("poll failed");
+                return;
+            }
+            continue;
+        }
+
+        for (int i = 0; i < s_config.devices && ready > 0; i++)
+        {
+            if (!(s_fds[i].revents & POLLIN))
+            {
+                continue;
+            }
+            ready--;
+            // drain the socket, as the command service does
+            while (1)
+            {
+                struct sockaddr_in source;
+                socklen_t socklen = sizeof(source);
+                int len = recvfrom(s_fds[i].fd, rx_buffer, sizeof(rx_buffer) - 1, MSG_DONTWAIT,
+                                   (struct sockaddr *)&source, &socklen);
+                if (len < 0)
+                {
+                    break;
+                }
+                int64_t rx_us = now_us();
+                rx_buffer[len] = 0;
+                s_stats.received++;
+                if (lost())
+                {
+                    s_stats.dropped++;
+                    continue;
+                }
+                handle_datagram(i, rx_buffer, len, &source, rx_us);
+            }
+        }
+    }
+}
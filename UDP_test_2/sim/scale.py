@@ -0,0 +1,96 @@
+"""Run the coordinator of server/server.py against the fleet simulator with a growing number of
+devices, and print the time until all ACKs were in and the coordinator throughput per fleet size.
+
+    python sim/scale.py --sim sim/build/fleet_sim.elf --devices 3 10 30 100 300 1000
+"""
+import argparse
+import asyncio
+import os
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "server"))
+from server import ACK_PORT, Coordinator, Session, open_socket, percentile  # noqa: E402
+
+
+def start_simulator(args, devices):
+    """Start the simulator and wait until its devices are listening"""
+    env = dict(os.environ, SIM_DEVICES=str(devices), SIM_BASE_PORT=str(args.base_port),
+               SIM_PROC_DELAY_US=str(args.delay_us), SIM_JITTER_US=str(args.jitter_us),
+               SIM_LOSS_PERMILLE=str(args.loss_permille))
+    sim = subprocess.Popen([args.sim], env=env, stdout=subprocess.PIPE, text=True)
+    line = sim.stdout.readline()
+    if not line.startswith("Fleet simulator"):
+        sim.kill()
+        raise SystemExit(f"[ERROR] Simulator didn't start: {line.strip()}")
+    return sim
+
+
+async def measure(args, devices):
+    ports = list(range(args.base_port, args.base_port + devices))
+    sock = open_socket(ACK_PORT)
+    transport, coordinator = await asyncio.get_running_loop().create_datagram_endpoint(
+        lambda: Coordinator("127.0.0.1", ports, "binary", False), sock=sock)
+    try:
+        await coordinator.discover()
+        await coordinator.sync_clocks(args.sync_rounds)
+        ids = [f"SIM_{i:04d}" for i in range(devices)]
+        sessions = [Session(coordinator, ids[i::args.sessions], args.delay_ms, True)
+                    for i in range(args.sessions) if ids[i::args.sessions]]
+        received, cpu = coordinator.received, time.process_time()
+        await asyncio.gather(*(session.run() for session in sessions))
+        cpu = time.process_time() - cpu
+    finally:
+        transport.close()
+
+    latencies = {dev: lat for session in sessions for dev, lat in session.latencies.items()}
+    acked = [lat * 1000 for lat in latencies.values() if lat is not None]
+    return {
+        "devices": devices,
+        "all_acked_ms": max(acked) if len(acked) == devices else None,
+        "p50_ms": percentile(acked, 50) if acked else None,
+        "p99_ms": percentile(acked, 99) if acked else None,
+        "missing": devices - len(acked),
+        "retransmits": coordinator.retransmits,
+        # datagrams handled per second of coordinator CPU time, its capacity
+        "throughput": (coordinator.received - received) / cpu if cpu else 0,
+    }
+
+
+def fmt(value):
+    return "-" if value is None else f"{value:.2f}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Scale test of server.py against the fleet simulator")
+    parser.add_argument("--sim", default="sim/build/fleet_sim.elf", help="fleet simulator executable")
+    parser.add_argument("--devices", type=int, nargs="+", default=[3, 10, 30, 100, 300, 1000],
+                        help="fleet sizes to measure")
+    parser.add_argument("--base-port", type=int, default=12345, help="command port of the first device")
+    parser.add_argument("--delay-us", type=int, default=100, help="device processing delay")
+    parser.add_argument("--jitter-us", type=int, default=0, help="device processing jitter")
+    parser.add_argument("--loss-permille", type=int, default=0, help="packet loss, each way")
+    parser.add_argument("--sessions", type=int, default=1, help="concurrent sessions per run")
+    parser.add_argument("--sync-rounds", type=int, default=4, help="clock sync rounds, they measure the RTT")
+    parser.add_argument("--delay-ms", type=int, default=2000, help="start delay of the sessions")
+    args = parser.parse_args()
+
+    results = []
+    for devices in args.devices:
+        sim = start_simulator(args, devices)
+        try:
+            results.append(asyncio.run(measure(args, devices)))
+        finally:
+            sim.terminate()
+            sim.wait()
+
+    print(f"\n{'devices':>8} {'all ACKs ms':>12} {'p50 ms':>8} {'p99 ms':>8} {'missing':>8} "
+          f"{'retransmits':>12} {'datagrams/CPU s':>16}")
+    for r in results:
+        print(f"{r['devices']:>8} {fmt(r['all_acked_ms']):>12} {fmt(r['p50_ms']):>8} {fmt(r['p99_ms']):>8} "
+              f"{r['missing']:>8} {r['retransmits']:>12} {r['throughput']:>16.0f}")
+
+
+if __name__ == "__main__":
+    main()
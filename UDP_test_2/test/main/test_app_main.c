@@ -0,0 +1,10 @@
+#include <stdlib.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    // the host build has nothing else to run, exit with the number of failures
+    exit(UNITY_END());
+}
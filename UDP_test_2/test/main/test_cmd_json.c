@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "cmd_json.h"
+
+#define FUZZ_ITERATIONS 200000
+#define FUZZ_MAX_LEN 160
+
+typedef struct
+{
+    const char *json;
+    const char *name; // expected "cmd"
+    uint32_t seq;
+    const char *id;
+} json_case_t;
+
+// Datagrams that have to be accepted, and what they hold
+static const json_case_t s_accepted[] = {
+    {"{\"cmd\":\"start\"}", "start", 0, ""},
+    {" {\r\n\t\"cmd\" : \"stop\" , \"seq\" : 7 }\n", "stop", 7, ""},
+    {"{\"seq\":1,\"cmd\":\"start\",\"session\":2,\"delay_ms\":3}", "start", 1, ""},
+    {"{\"cmd\":\"start\",\"cmd\":\"stop\"}", "stop", 0, ""}, // the last one wins
+    {"{\"cmd\":\"\"}", "", 0, ""},
+    {"{\"cmd\":\"abcdefghijklmno\"}", "abcdefghijklmno", 0, ""}, // CMD_JSON_NAME_MAX - 1 chars
+    {"{\"cmd\":\"start\",\"seq\":0}", "start", 0, ""},
+    {"{\"cmd\":\"start\",\"seq\":4294967295}", "start", UINT32_MAX, ""},
+    {"{\"cmd\":\"start\",\"x\":-12.5e-3}", "start", 0, ""}, // unknown keys take any number
+    {"{\"cmd\":\"start\",\"x\":true,\"y\":false,\"z\":null}", "start", 0, ""},
+    {"{\"cmd\":\"start\"} ", "start", 0, ""},
+    {"{\"cmd\":\"st\\u0061rt\"}", "start", 0, ""},
+    {"{\"cmd\":\"st\\u0041RT\"}", "stART", 0, ""},
+    {"{\"cmd\":\"a\\\"b\\\\c\\/\"}", "a\"b\\c/", 0, ""},
+    {"{\"c\\u006dd\":\"start\"}", "start", 0, ""},
+    {"{\"cmd\":\"start\",\"x\":\"\\u00e9\\u0000\"}", "start", 0, ""}, // skipped strings can have any escape
+    {"{\"cmd\":\"start\",\"seqseqseqseqseqseq\":-1}", "start", 0, ""}, // too long for a known key
+    {"{\"cmd\":\"start\",\"id\":\"ABCDEFGHIJKL\"}", "start", 0, "ABCDEFGHIJKL"}, // CMD_PROTO_ID_LEN chars
+};
+
+// Datagrams that have to be rejected
+static const char *const s_rejected[] = {
+    "",
+    "{}",
+    "[]",
+    "\"cmd\"",
+    "{\"seq\":1}",
+    "{\"cmd\":\"abcdefghijklmnop\"}",
+    // numbers: leading zeros, out of range, not an unsigned integer
+    "{\"cmd\":\"start\",\"seq\":007}",
+    "{\"cmd\":\"start\",\"seq\":00}",
+    "{\"cmd\":\"start\",\"x\":01}",
+    "{\"cmd\":\"start\",\"seq\":4294967296}",
+    "{\"cmd\":\"start\",\"seq\":99999999999999999999999}",
+    "{\"cmd\":\"start\",\"seq\":-1}",
+    "{\"cmd\":\"start\",\"seq\":-0}",
+    "{\"cmd\":\"start\",\"seq\":1.0}",
+    "{\"cmd\":\"start\",\"seq\":1e3}",
+    "{\"cmd\":\"start\",\"seq\":+1}",
+    "{\"cmd\":\"start\",\"seq\":\"1\"}",
+    "{\"cmd\":\"start\",\"seq\":}",
+    "{\"cmd\":\"start\",\"x\":1.}",
+    "{\"cmd\":\"start\",\"x\":1e}",
+    "{\"cmd\":\"start\",\"x\":tru}",
+    // nesting isn't part of the schema
+    "{\"cmd\":\"start\",\"x\":{}}",
+    "{\"cmd\":\"start\",\"x\":[1]}",
+    "{\"cmd\":{\"cmd\":\"start\"}}",
+    // trailing garbage and truncation
+    "{\"cmd\":\"start\"}x",
+    "{\"cmd\":\"start\"}{}",
+    "{\"cmd\":\"start\",}",
+    "{\"cmd\":\"start\" \"seq\":1}",
+    "{\"cmd\":\"start\"",
+    "{\"cmd\":\"start\\",
+    // escapes, only ASCII can be copied
+    "{\"cmd\":\"\\u00e9\"}",
+    "{\"cmd\":\"\\u0000\"}",
+    "{\"cmd\":\"\\u12\"}",
+    "{\"cmd\":\"\\uZZZZ\"}",
+    "{\"cmd\":\"\\x\"}",
+    "{\"cmd\":\"a\nb\"}", // unescaped control character
+    // device id
+    "{\"cmd\":\"start\",\"id\":\"ABCDEFGHIJKLM\"}",
+    "{\"cmd\":\"start\",\"id\":7}",
+};
+
+#define ACCEPTED_COUNT (sizeof(s_accepted) / sizeof(s_accepted[0]))
+#define REJECTED_COUNT (sizeof(s_rejected) / sizeof(s_rejected[0]))
+
+// Parse a copy of exactly len bytes, so a read past the end is caught by the sanitizers
+static int parse_copy(const void *json, size_t len, char *name, size_t name_size, cmd_msg_t *msg)
+{
+    char *buf = malloc(len ? len : 1);
+    TEST_ASSERT_NOT_NULL(buf);
+    memcpy(buf, json, len);
+    int ret = cmd_json_parse(buf, len, name, name_size, msg);
+    free(buf);
+    return ret;
+}
+
+TEST_CASE("cmd_json accepts well-formed commands", "[cmd_json]")
+{
+    for (size_t i = 0; i < ACCEPTED_COUNT; i++)
+    {
+        const json_case_t *c = &s_accepted[i];
+        char name[CMD_JSON_NAME_MAX];
+        cmd_msg_t msg;
+        TEST_ASSERT_EQUAL_MESSAGE(0, parse_copy(c->json, strlen(c->json), name, sizeof(name), &msg), c->json);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(c->name, name, c->json);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(c->seq, msg.seq, c->json);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(c->id, msg.device_id, c->json);
+    }
+}
+
+TEST_CASE("cmd_json rejects malformed commands", "[cmd_json]")
+{
+    for (size_t i = 0; i < REJECTED_COUNT; i++)
+    {
+        char name[CMD_JSON_NAME_MAX];
+        cmd_msg_t msg;
+        TEST_ASSERT_EQUAL_MESSAGE(-1, parse_copy(s_rejected[i], strlen(s_rejected[i]), name, sizeof(name), &msg),
+                                  s_rejected[i]);
+    }
+}
+
+TEST_CASE("cmd_json reads the fields into the message", "[cmd_json]")
+{
+    const char *json = "{\"cmd\":\"start\",\"seq\":1,\"session\":4000000000,\"delay_ms\":10000,\"id\":\"ESP32_A\"}";
+    char name[CMD_JSON_NAME_MAX];
+    cmd_msg_t msg;
+    TEST_ASSERT_EQUAL(0, cmd_json_parse(json, strlen(json), name, sizeof(name), &msg));
+    TEST_ASSERT_EQUAL_STRING("start", name);
+    TEST_ASSERT_EQUAL_UINT32(1, msg.seq);
+    TEST_ASSERT_EQUAL_UINT32(4000000000u, msg.session);
+    TEST_ASSERT_EQUAL_UINT32(10000, msg.delay_ms);
+    TEST_ASSERT_EQUAL_STRING("ESP32_A", msg.device_id);
+
+    // a name buffer smaller than CMD_JSON_NAME_MAX limits the name
+    char small[5];
+    TEST_ASSERT_EQUAL(-1, cmd_json_parse(json, strlen(json), small, sizeof(small), &msg));
+    // the datagram is not required to be zero terminated
+    TEST_ASSERT_EQUAL(-1, cmd_json_parse(json, strlen(json) - 1, name, sizeof(name), &msg));
+}
+
+// xorshift32, a fixed seed makes a failure reproducible
+static uint32_t fuzz_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Byte values the parser branches on are more likely than random ones
+static uint8_t fuzz_byte(uint32_t *state)
+{
+    static const char interesting[] = "{}[]\":,\\u0123456789-+.eE \t\nabfnrtx";
+    uint32_t r = fuzz_random(state);
+    return (r & 1) ? (uint8_t)interesting[(r >> 1) % (sizeof(interesting) - 1)] : (uint8_t)(r >> 8);
+}
+
+TEST_CASE("cmd_json survives mutated datagrams", "[cmd_json][fuzz]")
+{
+    uint32_t state = 0x5544;
+    uint8_t work[FUZZ_MAX_LEN];
+    int accepted = 0;
+
+    for (int iter = 0; iter < FUZZ_ITERATIONS; iter++)
+    {
+        uint32_t pick = fuzz_random(&state) % (ACCEPTED_COUNT + REJECTED_COUNT);
+        const char *seed = pick < ACCEPTED_COUNT ? s_accepted[pick].json : s_rejected[pick - ACCEPTED_COUNT];
+        size_t len = strlen(seed);
+        memcpy(work, seed, len);
+
+        int mutations = 1 + fuzz_random(&state) % 4;
+        for (int m = 0; m < mutations; m++)
+        {
+            size_t pos = len ? fuzz_random(&state) % len : 0;
+            switch (fuzz_random(&state) % 4)
+            {
+            case 0: // flip a bit
+                if (len)
+                {
+                    work[pos] ^= 1u << (fuzz_random(&state) % 8);
+                }
+                break;
+            case 1: // replace a byte
+                if (len)
+                {
+                    work[pos] = fuzz_byte(&state);
+                }
+                break;
+            case 2: // insert a byte
+                if (len < FUZZ_MAX_LEN)
+                {
+                    memmove(work + pos + 1, work + pos, len - pos);
+                    work[pos] = fuzz_byte(&state);
+                    len++;
+                }
+                break;
+            default: // delete a byte
+                if (len)
+                {
+                    memmove(work + pos, work + pos + 1, len - pos - 1);
+                    len--;
+                }
+                break;
+            }
+        }
+
+        // guard bytes after the name, the parser must not write past name_size
+        struct
+        {
+            char name[CMD_JSON_NAME_MAX];
+            uint32_t guard;
+        } out;
+        out.guard = 0xA5A5A5A5;
+        cmd_msg_t msg;
+        int ret = parse_copy(work, len, out.name, sizeof(out.name), &msg);
+
+        TEST_ASSERT(ret == 0 || ret == -1);
+        TEST_ASSERT_EQUAL_UINT32(0xA5A5A5A5, out.guard);
+        TEST_ASSERT_EQUAL(0, msg.device_id[CMD_PROTO_ID_LEN]);
+        if (ret == 0)
+        {
+            TEST_ASSERT(memchr(out.name, '\0', sizeof(out.name)) != NULL);
+            accepted++;
+        }
+    }
+    // the mutations have to leave some datagrams valid, or only the first checks are reached
+    TEST_ASSERT(accepted > 0);
+}
@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "led_strip.h"
+#include "sdkconfig.h"
+#if CONFIG_SOC_GPSPI_SUPPORTED
+#include "led_strip_spi_encoder.h"
+#endif
+
+// GPIO assignment
+#define LED_STRIP_GPIO        2
+// Numbers of the LED in the strip, the frame is only built in memory so no strip has to be connected
+#define LED_STRIP_LED_NUMBERS 1024
+// 10MHz resolution, 1 tick = 0.1us (led strip needs a high resolution)
+#define LED_STRIP_RMT_RES_HZ  (10 * 1000 * 1000)
+// How many frames to build for each measurement
+#define BENCHMARK_ROUNDS      100
+// How many frames to send out for each refresh measurement
+#define REFRESH_ROUNDS        20
+// Chunk size of the streaming SPI backend
+#define SPI_STREAM_CHUNK_LEDS 64
+// Clock line and clock speed of the APA102 strip
+#define APA102_CLK_GPIO       3
+#define APA102_CLOCK_HZ       (20 * 1000 * 1000)
+
+static const char *TAG = "benchmark";
+
+typedef struct {
+    int64_t start_us;
+    uint32_t start_cycles;
+} bench_t;
+
+static void bench_begin(bench_t *bench)
+{
+    bench->start_us = esp_timer_get_time();
+    bench->start_cycles = esp_cpu_get_cycle_count();
+}
+
+static void bench_end(const bench_t *bench, const char *name)
+{
+    // the cycle counter is 32 bits wide, keep each measurement well below its wrap-around period
+    uint32_t cycles = esp_cpu_get_cycle_count() - bench->start_cycles;
+    int64_t elapsed_us = esp_timer_get_time() - bench->start_us;
+    uint32_t pixels = BENCHMARK_ROUNDS * LED_STRIP_LED_NUMBERS;
+    ESP_LOGI(TAG, "%-32s %6" PRId64 " us/frame %5" PRId64 " ns/pixel %5" PRIu32 " cycles/pixel",
+             name, elapsed_us / BENCHMARK_ROUNDS, elapsed_us * 1000 / pixels, cycles / pixels);
+}
+
+static void bench_set_pixel(led_strip_handle_t led_strip, const uint8_t *rgb, const char *name)
+{
+    bench_t bench;
+    bench_begin(&bench);
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        for (int i = 0; i < LED_STRIP_LED_NUMBERS; i++) {
+            ESP_ERROR_CHECK(led_strip_set_pixel(led_strip, i, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]));
+        }
+    }
+    bench_end(&bench, name);
+}
+
+static void bench_set_pixels(led_strip_handle_t led_strip, const uint8_t *colors, led_color_format_t format, const char *name)
+{
+    bench_t bench;
+    bench_begin(&bench);
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        ESP_ERROR_CHECK(led_strip_set_pixels(led_strip, 0, LED_STRIP_LED_NUMBERS, colors, format));
+    }
+    bench_end(&bench, name);
+}
+
+static void bench_rmt_backend(const uint8_t *colors)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = LED_STRIP_GPIO,
+        .max_leds = LED_STRIP_LED_NUMBERS,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = LED_STRIP_RMT_RES_HZ,
+    };
+    led_strip_handle_t led_strip;
+    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
+
+    bench_set_pixel(led_strip, colors, "rmt: led_strip_set_pixel loop");
+    bench_set_pixels(led_strip, colors, LED_COLOR_FORMAT_RGB, "rmt: led_strip_set_pixels (RGB)");
+    bench_set_pixels(led_strip, colors, LED_COLOR_FORMAT_GRB, "rmt: led_strip_set_pixels (GRB)");
+
+    ESP_ERROR_CHECK(led_strip_del(led_strip));
+}
+
+static void bench_spi_backend(const uint8_t *colors)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = LED_STRIP_GPIO,
+        .max_leds = LED_STRIP_LED_NUMBERS,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_spi_config_t spi_config = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,
+        .spi_bus = SPI2_HOST,
+        .flags.with_dma = true,
+    };
+    led_strip_handle_t led_strip;
+    ESP_ERROR_CHECK(led_strip_new_spi_device(&strip_config, &spi_config, &led_strip));
+
+    // the SPI backend only stores the GRB bytes here, the bit waveform is encoded by the refresh
+    bench_set_pixel(led_strip, colors, "spi: led_strip_set_pixel loop");
+    bench_set_pixels(led_strip, colors, LED_COLOR_FORMAT_RGB, "spi: led_strip_set_pixels (RGB)");
+
+    ESP_ERROR_CHECK(led_strip_del(led_strip));
+}
+
+#if CONFIG_LED_STRIP_SPI_ENCODE_TABLE_IN_DRAM
+#define SPI_ENCODE_TABLE_LOCATION "DRAM"
+#else
+#define SPI_ENCODE_TABLE_LOCATION "flash"
+#endif
+
+// Time the encoding done by the SPI backend at each refresh, from GRB bytes into the SPI waveform
+static void bench_spi_encode(const uint8_t *colors)
+{
+    size_t frame_bytes = LED_STRIP_LED_NUMBERS * 3;
+    uint8_t *frame_buf = heap_caps_malloc(frame_bytes * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    assert(frame_buf);
+    // a gamma curve, the same one for all three components
+    uint8_t gamma[256];
+    for (int i = 0; i < 256; i++) {
+        gamma[i] = i * i / 255;
+    }
+    const uint8_t *lut[3] = {gamma, gamma, gamma};
+
+    bench_t bench;
+    bench_begin(&bench);
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        led_strip_spi_encode_bytes(colors, frame_bytes, NULL, 3, frame_buf);
+    }
+    bench_end(&bench, "spi: encode (" SPI_ENCODE_TABLE_LOCATION " table)");
+
+    bench_begin(&bench);
+    for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+        led_strip_spi_encode_bytes(colors, frame_bytes, lut, 3, frame_buf);
+    }
+    bench_end(&bench, "spi: encode + LUT (" SPI_ENCODE_TABLE_LOCATION " table)");
+
+    free(frame_buf);
+}
+
+static void bench_spi_refresh(uint32_t led_numbers, uint32_t stream_chunk_leds)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = LED_STRIP_GPIO,
+        .max_leds = led_numbers,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_spi_config_t spi_config = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,
+        .spi_bus = SPI2_HOST,
+        .stream_chunk_leds = stream_chunk_leds,
+        .flags.with_dma = true,
+    };
+    const char *mode = stream_chunk_leds ? "streaming" : "full frame";
+    size_t free_dma = heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    size_t free_all = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    led_strip_handle_t led_strip;
+    esp_err_t ret = led_strip_new_spi_device(&strip_config, &spi_config, &led_strip);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "spi %-10s %4" PRIu32 " LEDs: can't create the strip (%s)", mode, led_numbers, esp_err_to_name(ret));
+        return;
+    }
+    size_t used_dma = free_dma - heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    size_t used_all = free_all - heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < REFRESH_ROUNDS; round++) {
+        ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+    }
+    int64_t frame_us = (esp_timer_get_time() - start) / REFRESH_ROUNDS;
+    ESP_LOGI(TAG, "spi %-10s %4" PRIu32 " LEDs: %6zu bytes RAM (%6zu DMA) %6" PRId64 " us/frame %4" PRId64 " fps",
+             mode, led_numbers, used_all, used_dma, frame_us, 1000000 / frame_us);
+    ESP_ERROR_CHECK(led_strip_del(led_strip));
+}
+
+static void bench_apa102_refresh(uint32_t led_numbers)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = LED_STRIP_GPIO,
+        .max_leds = led_numbers,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+        .led_model = LED_MODEL_APA102,
+    };
+    led_strip_spi_config_t spi_config = {
+        .clk_src = SPI_CLK_SRC_DEFAULT,
+        .spi_bus = SPI2_HOST,
+        .clk_gpio_num = APA102_CLK_GPIO,
+        .clock_speed_hz = APA102_CLOCK_HZ,
+        .flags.with_dma = true,
+    };
+    led_strip_handle_t led_strip;
+    esp_err_t ret = led_strip_new_spi_device(&strip_config, &spi_config, &led_strip);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "apa102 %4" PRIu32 " LEDs: can't create the strip (%s)", led_numbers, esp_err_to_name(ret));
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < REFRESH_ROUNDS; round++) {
+        ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+    }
+    int64_t frame_us = (esp_timer_get_time() - start) / REFRESH_ROUNDS;
+    ESP_LOGI(TAG, "apa102 %4" PRIu32 " LEDs: %6" PRId64 " us/frame %5" PRId64 " fps", led_numbers, frame_us, 1000000 / frame_us);
+    ESP_ERROR_CHECK(led_strip_del(led_strip));
+}
+
+void app_main(void)
+{
+    uint8_t *colors = malloc(LED_STRIP_LED_NUMBERS * 3);
+    assert(colors);
+    for (int i = 0; i < LED_STRIP_LED_NUMBERS * 3; i++) {
+        colors[i] = i & 0xFF;
+    }
+
+    ESP_LOGI(TAG, "Building %d frames of %d LEDs", BENCHMARK_ROUNDS, LED_STRIP_LED_NUMBERS);
+#if CONFIG_SOC_RMT_SUPPORTED
+    bench_rmt_backend(colors);
+#endif
+#if CONFIG_SOC_GPSPI_SUPPORTED
+    bench_spi_backend(colors);
+    bench_spi_encode(colors);
+    const uint32_t refresh_led_numbers[] = {300, 1000, 3000};
+    for (int i = 0; i < sizeof(refresh_led_numbers) / sizeof(refresh_led_numbers[0]); i++) {
+        bench_spi_refresh(refresh_led_numbers[i], 0);
+        bench_spi_refresh(refresh_led_numbers[i], SPI_STREAM_CHUNK_LEDS);
+        bench_apa102_refresh(refresh_led_numbers[i]);
+    }
+#endif
+
+    free(colors);
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+#include "esp_err.h"
+#include "led_strip.h"
+
+// Each measurement covers at least this many pixels, so short strips are measured over more rounds
+#define BENCHMARK_MIN_PIXELS (1000 * 1000)
+// Every line of the results starts with this tag, followed by one JSON object
+#define BENCHMARK_TAG        "LED_STRIP_BENCHMARK"
+
+static const uint32_t s_led_numbers[] = {64, 300, 1000, 3000};
+
+static const struct {
+    led_pixel_format_t format;
+    const char *name;
+} s_formats[] = {
+    {LED_PIXEL_FORMAT_GRB, "GRB"},
+    {LED_PIXEL_FORMAT_GRBW, "GRBW"},
+};
+
+// encoder tells what encode_ns measures: the RMT sink is filled by the mock's own loop over the bits, not by the RMT encoder
+// of the driver, which needs the RMT peripheral. The SPI sink is filled with the encoding table of the SPI backend
+static const struct {
+    led_strip_mock_sink_t sink;
+    const char *name;
+    const char *encoder;
+} s_sinks[] = {
+    {LED_STRIP_MOCK_SINK_RMT, "rmt", "mock_sink"},
+    {LED_STRIP_MOCK_SINK_SPI, "spi", "spi_table"},
+};
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double ns_per_pixel(int64_t start_ns, uint32_t rounds, uint32_t led_numbers)
+{
+    return (double)(now_ns() - start_ns) / ((double)rounds * led_numbers);
+}
+
+static void bench_strip(led_strip_mock_sink_t sink, const char *sink_name, const char *encoder, led_pixel_format_t format,
+                        const char *format_name, uint32_t led_numbers, const uint8_t *colors)
+{
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = -1,
+        .max_leds = led_numbers,
+        .led_pixel_format = format,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_mock_config_t mock_config = {
+        .sink = sink,
+    };
+    led_strip_handle_t led_strip;
+    ESP_ERROR_CHECK(led_strip_new_mock_device(&strip_config, &mock_config, &led_strip));
+    uint32_t rounds = (BENCHMARK_MIN_PIXELS + led_numbers - 1) / led_numbers;
+
+    int64_t start = now_ns();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint32_t i = 0; i < led_numbers; i++) {
+            ESP_ERROR_CHECK(led_strip_set_pixel(led_strip, i, colors[i * 3], colors[i * 3 + 1], colors[i * 3 + 2]));
+        }
+    }
+    double set_pixel_ns = ns_per_pixel(start, rounds, led_numbers);
+
+    start = now_ns();
+    for (uint32_t round = 0; round < rounds; round++) {
+        ESP_ERROR_CHECK(led_strip_set_pixels(led_strip, 0, led_numbers, colors, LED_COLOR_FORMAT_RGB));
+    }
+    double set_pixels_ns = ns_per_pixel(start, rounds, led_numbers);
+
+    // refreshing the mock strip only encodes the pixels into memory
+    start = now_ns();
+    for (uint32_t round = 0; round < rounds; round++) {
+        ESP_ERROR_CHECK(led_strip_refresh(led_strip));
+    }
+    double encode_ns = ns_per_pixel(start, rounds, led_numbers);
+
+    start = now_ns();
+    for (uint32_t round = 0; round < rounds; round++) {
+        ESP_ERROR_CHECK(led_strip_clear(led_strip));
+    }
+    double clear_ns = ns_per_pixel(start, rounds, led_numbers);
+
+    const void *waveform;
+    size_t waveform_size;
+    ESP_ERROR_CHECK(led_strip_mock_get_sink(led_strip, &waveform, &waveform_size));
+    printf(BENCHMARK_TAG " {\"sink\": \"%s\", \"encoder\": \"%s\", \"format\": \"%s\", \"leds\": %" PRIu32 ", \"rounds\": %" PRIu32 ", "
+           "\"waveform_bytes\": %zu, \"set_pixel_ns\": %.2f, \"set_pixels_ns\": %.2f, \"encode_ns\": %.2f, \"clear_ns\": %.2f}\n",
+           sink_name, encoder, format_name, led_numbers, rounds, waveform_size, set_pixel_ns, set_pixels_ns, encode_ns, clear_ns);
+    ESP_ERROR_CHECK(led_strip_del(led_strip));
+}
+
+void app_main(void)
+{
+    uint32_t max_leds = s_led_numbers[sizeof(s_led_numbers) / sizeof(s_led_numbers[0]) - 1];
+    uint8_t *colors = malloc(max_leds * 3);
+    assert(colors);
+    for (uint32_t i = 0; i < max_leds * 3; i++) {
+        colors[i] = i & 0xFF;
+    }
+
+    for (int s = 0; s < sizeof(s_sinks) / sizeof(s_sinks[0]); s++) {
+        for (int f = 0; f < sizeof(s_formats) / sizeof(s_formats[0]); f++) {
+            for (int n = 0; n < sizeof(s_led_numbers) / sizeof(s_led_numbers[0]); n++) {
+                bench_strip(s_sinks[s].sink, s_sinks[s].name, s_sinks[s].encoder, s_formats[f].format, s_formats[f].name, s_led_numbers[n], colors);
+            }
+        }
+    }
+    printf(BENCHMARK_TAG " DONE\n");
+    fflush(stdout);
+
+    free(colors);
+    exit(0);
+}
@@ -0,0 +1,27 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+import json
+import logging
+import os
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_led_strip_host_benchmark(dut: IdfDut) -> None:
+    results = []
+    while True:
+        line = dut.expect(r'LED_STRIP_BENCHMARK (.+?)\r?\n', timeout=120).group(1).decode()
+        if line == 'DONE':
+            break
+        results.append(json.loads(line))
+
+    assert results
+    for result in results:
+        logging.info('{sink} ({encoder}) {format} {leds} LEDs: set_pixel {set_pixel_ns} ns/pixel, set_pixels {set_pixels_ns} ns/pixel, '
+                     'encode {encode_ns} ns/pixel, clear {clear_ns} ns/pixel'.format(**result))
+    # keep the results for regression tracking
+    with open(os.path.join(dut.logdir, 'led_strip_host_benchmark.json'), 'w') as f:
+        json.dump(results, f, indent=2)
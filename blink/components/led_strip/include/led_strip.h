@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "led_strip_types.h"
+#include "esp_idf_version.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+// the host build has no RMT nor SPI peripheral, only the mock backend is available
+#include "led_strip_mock.h"
+#else
+#include "led_strip_rmt.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#include "led_strip_spi.h"
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set RGB for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ *
+ * @return
+ *      - ESP_OK: Set RGB for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+ *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+/**
+ * @brief Set RGBW for a specific pixel
+ *
+ * @note Only call this function if your led strip does have the white component (e.g. SK6812-RGBW)
+ * @note Also see `led_strip_set_pixel` if you only want to specify the RGB part of the color and bypass the white component
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ * @param white: separate white component
+ *
+ * @return
+ *      - ESP_OK: Set RGBW color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+/**
+ * @brief Set colors for a range of consecutive pixels
+ *
+ * @note The whole range is checked once, then the colors are copied into the strip's buffer in a tight loop.
+ *       It's much faster than calling `led_strip_set_pixel` for each pixel.
+ * @note If the color format doesn't carry a white component while the LED strip has one, the white component is set to zero.
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param colors: color data, `count` pixels laid out as described by `format`
+ * @param format: layout of the color data
+ *
+ * @return
+ *      - ESP_OK: Set colors for the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set colors for the pixels failed because of invalid parameters (e.g. the range exceeds the strip length)
+ *      - ESP_ERR_NOT_SUPPORTED: Set colors for the pixels failed because the backend doesn't support it
+ *      - ESP_FAIL: Set colors for the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format);
+
+/**
+ * @brief Set HSV for a specific pixel
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param hue: hue part of color (0 - 360)
+ * @param saturation: saturation part of color (0 - 255, rescaled from 0 - 1. e.g. saturation = 0.5, rescaled to 127)
+ * @param value: value part of color (0 - 255, rescaled from 0 - 1. e.g. value = 0.5, rescaled to 127)
+ *
+ * @return
+ *      - ESP_OK: Set HSV color for a specific pixel successfully
+ *      - ESP_ERR_INVALID_ARG: Set HSV color for a specific pixel failed because of an invalid argument
+ *      - ESP_FAIL: Set HSV color for a specific pixel failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value);
+
+/**
+ * @brief Set color look-up tables, which are applied to the pixels when they're sent out
+ *
+ * @note The pixels in memory keep their original values, so e.g. changing the global brightness only needs to rebuild the tables,
+ *       followed by a `led_strip_refresh`, rather than setting all pixels again.
+ * @note The tables are not copied, they must stay valid until they're replaced or the strip is deleted.
+ *       Frames being sent out are waited for before the tables are replaced, but don't modify the tables in place while refreshing.
+ *
+ * @param strip: LED strip
+ * @param lut: color look-up tables, or NULL to send the colors as they are
+ *
+ * @return
+ *      - ESP_OK: Set color look-up tables successfully
+ *      - ESP_ERR_INVALID_ARG: Set color look-up tables failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: Set color look-up tables failed because the backend doesn't support it
+ *      - ESP_FAIL: Set color look-up tables failed because other error occurred
+ */
+esp_err_t led_strip_set_color_lut(led_strip_handle_t strip, const led_strip_color_lut_t *lut);
+
+/**
+ * @brief Set the brightness of a specific pixel
+ *
+ * @note Only for the LED models with a 5-bit brightness per pixel (`LED_MODEL_APA102`, `LED_MODEL_SK9822`).
+ *       The brightness defaults to the maximum and is kept by `led_strip_set_pixel` and `led_strip_clear`.
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param brightness: brightness of the pixel (0 - 31)
+ *
+ * @return
+ *      - ESP_OK: Set the brightness successfully
+ *      - ESP_ERR_INVALID_ARG: Set the brightness failed because of invalid parameters
+ *      - ESP_ERR_NOT_SUPPORTED: Set the brightness failed because the LED model has no per-pixel brightness
+ *      - ESP_FAIL: Set the brightness failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_brightness(led_strip_handle_t strip, uint32_t index, uint8_t brightness);
+
+/**
+ * @brief Set the color of a palette entry
+ *
+ * @note Only for the strips with an indexed pixel format (`LED_PIXEL_FORMAT_INDEXED8` or `LED_PIXEL_FORMAT_INDEXED4`).
+ *       All pixels showing this entry change their color with the next `led_strip_refresh`, so e.g. color cycling only updates the palette.
+ * @note The palette is initialized to black.
+ *
+ * @param strip: LED strip
+ * @param palette_index: index of the palette entry (0 - 255 for `LED_PIXEL_FORMAT_INDEXED8`, 0 - 15 for `LED_PIXEL_FORMAT_INDEXED4`)
+ * @param red: red part of color
+ * @param green: green part of color
+ * @param blue: blue part of color
+ *
+ * @return
+ *      - ESP_OK: Set the palette color successfully
+ *      - ESP_ERR_INVALID_ARG: Set the palette color failed because of invalid parameters, or the strip is not indexed
+ *      - ESP_ERR_NOT_SUPPORTED: Set the palette color failed because the backend doesn't support indexed pixel formats
+ *      - ESP_FAIL: Set the palette color failed because other error occurred
+ */
+esp_err_t led_strip_set_palette_color(led_strip_handle_t strip, uint32_t palette_index, uint32_t red, uint32_t green, uint32_t blue);
+
+/**
+ * @brief Set the palette index of a specific pixel
+ *
+ * @note Only for the strips with an indexed pixel format. `led_strip_clear` sets all pixels to the palette entry 0.
+ *
+ * @param strip: LED strip
+ * @param index: index of pixel to set
+ * @param palette_index: index of the palette entry
+ *
+ * @return
+ *      - ESP_OK: Set the palette index successfully
+ *      - ESP_ERR_INVALID_ARG: Set the palette index failed because of invalid parameters, or the strip is not indexed
+ *      - ESP_ERR_NOT_SUPPORTED: Set the palette index failed because the backend doesn't support indexed pixel formats
+ *      - ESP_FAIL: Set the palette index failed because other error occurred
+ */
+esp_err_t led_strip_set_pixel_index(led_strip_handle_t strip, uint32_t index, uint32_t palette_index);
+
+/**
+ * @brief Refresh memory colors to LEDs
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Refresh successfully
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ *
+ * @note:
+ *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+ */
+esp_err_t led_strip_refresh(led_strip_handle_t strip);
+
+/**
+ * @brief Start flushing memory colors to LEDs without waiting for the transmission to finish
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Start refreshing successfully
+ *      - ESP_ERR_NOT_SUPPORTED: Start refreshing failed because the backend doesn't support asynchronous refresh
+ *      - ESP_FAIL: Start refreshing failed because some other error occurred
+ *
+ * @note:
+ *      The colors are copied into a second buffer before being sent, so the caller can set the pixels of the next frame
+ *      while the current one is still on the wire. If a previous frame is still being sent, this function waits for it first.
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip);
+
+/**
+ * @brief Wait for the frame started by `led_strip_refresh_async` to be completely sent out
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: Wait timeout, in ms. Specially, -1 means to wait forever
+ *
+ * @return
+ *      - ESP_OK: All pending frames have been sent out
+ *      - ESP_ERR_TIMEOUT: The frame is still being sent out when the timeout expired
+ *      - ESP_ERR_NOT_SUPPORTED: Wait failed because the backend doesn't support asynchronous refresh
+ *      - ESP_FAIL: Wait failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_wait_done(led_strip_handle_t strip, int timeout_ms);
+
+/**
+ * @brief Set callbacks for LED strip events
+ *
+ * @note The callbacks are running in ISR context, so they should not attempt to block.
+ *       When CONFIG_RMT_ISR_IRAM_SAFE is enabled, the callbacks and the data they access should be placed in internal RAM.
+ * @note Any frame still being sent out is waited for before the callbacks are replaced.
+ *
+ * @param strip: LED strip
+ * @param cbs: Group of callback functions, set a member to NULL to disable the corresponding callback
+ * @param user_ctx: User data, which will be passed to the callback functions directly
+ *
+ * @return
+ *      - ESP_OK: Set event callbacks successfully
+ *      - ESP_ERR_INVALID_ARG: Set event callbacks failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: Set event callbacks failed because the backend doesn't support asynchronous refresh
+ *      - ESP_ERR_INVALID_STATE: Set event callbacks failed because the strip belongs to a `led_strip_group_t`
+ *      - ESP_FAIL: Set event callbacks failed because some other error occurred
+ */
+esp_err_t led_strip_register_event_callbacks(led_strip_handle_t strip, const led_strip_event_callbacks_t *cbs, void *user_ctx);
+
+/**
+ * @brief Clear LED strip (turn off all LEDs)
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Clear LEDs successfully
+ *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+ */
+esp_err_t led_strip_clear(led_strip_handle_t strip);
+
+/**
+ * @brief Free LED strip resources
+ *
+ * @param strip: LED strip
+ *
+ * @return
+ *      - ESP_OK: Free resources successfully
+ *      - ESP_FAIL: Free resources failed because error occurred
+ */
+esp_err_t led_strip_del(led_strip_handle_t strip);
+
+#ifdef __cplusplus
+}
+#endif
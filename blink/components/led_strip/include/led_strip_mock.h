@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Waveform written by the mock backend into its memory sink
+ */
+typedef enum {
+    LED_STRIP_MOCK_SINK_RMT,    /*!< RMT symbols (32 bits each), one per bit plus the reset code, as the RMT backend sends them */
+    LED_STRIP_MOCK_SINK_SPI,    /*!< SPI bytes, 3 per color byte, as the SPI backend sends them */
+    LED_STRIP_MOCK_SINK_INVALID /*!< Invalid sink */
+} led_strip_mock_sink_t;
+
+/**
+ * @brief LED Strip mock specific configuration
+ */
+typedef struct {
+    led_strip_mock_sink_t sink; /*!< Waveform written into the memory sink on each refresh */
+    uint32_t resolution_hz;     /*!< Tick resolution of the RMT symbols, if set to zero, a default resolution (10MHz) will be applied */
+} led_strip_mock_config_t;
+
+/**
+ * @brief Create LED strip whose waveform is written into memory, for the host (linux target) builds
+ *
+ * @note No peripheral is used. `led_strip_refresh` encodes the pixels, like the RMT or SPI backend does,
+ *       into a memory sink, which can be read back by `led_strip_mock_get_sink`.
+ *       It's meant for testing and benchmarking the applications and the driver without a board.
+ * @note `led_strip_refresh_async` takes a snapshot of the pixels, like the RMT backend does, and the frame stays "on the wire"
+ *       until it's waited for by `led_strip_refresh_wait_done` or the next frame is started. Only then it's encoded into the sink
+ *       and the `on_refresh_done` callback is invoked, from the calling task.
+ * @note The indexed pixel formats and the clocked LED models are not supported.
+ *
+ * @param led_config LED strip configuration
+ * @param mock_config Mock specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: create LED strip handle failed because of unsupported configuration
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ */
+esp_err_t led_strip_new_mock_device(const led_strip_config_t *led_config, const led_strip_mock_config_t *mock_config, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Get the waveform of the last frame a mock LED strip has sent out
+ *
+ * @param strip LED strip, created by `led_strip_new_mock_device`
+ * @param ret_data Returned start of the waveform, valid until the strip is deleted
+ * @param ret_size Returned size of the waveform in bytes, zero if no frame has been sent out yet
+ * @return
+ *      - ESP_OK: get the waveform successfully
+ *      - ESP_ERR_INVALID_ARG: get the waveform failed because of invalid argument
+ */
+esp_err_t led_strip_mock_get_sink(led_strip_handle_t strip, const void **ret_data, size_t *ret_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+#include "esp_idf_version.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "driver/rmt_types.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED Strip RMT specific configuration
+ */
+typedef struct {
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+    uint8_t rmt_channel;        /*!< Specify the channel number, the legacy RMT driver doesn't support channel allocator */
+#else // new driver supports specify the clock source and clock resolution
+    rmt_clock_source_t clk_src; /*!< RMT clock source */
+    uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
+#endif
+    size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+    struct {
+        uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_rmt_config_t;
+
+/**
+ * @brief Create LED strip based on RMT TX channel
+ *
+ * @param led_config LED strip configuration
+ * @param rmt_config RMT specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip);
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+/**
+ * @brief Create LED strip based on RMT TX channel, whose pixels are generated by a callback while they're sent out
+ *
+ * @note No pixel buffer is allocated, so the strip length is not limited by the free memory.
+ *       `led_strip_set_pixel` and the other functions setting pixels return `ESP_ERR_NOT_SUPPORTED`,
+ *       and `led_strip_clear` sends out a black frame without calling the generator.
+ * @note The generator is called for every pixel of every refresh, mostly from the ISR context. See `led_strip_pixel_generator_t`.
+ *       With `led_strip_refresh_async`, the frame is generated after the function returns, so the state read by the generator
+ *       must not be changed before the refresh is done.
+ * @note The indexed pixel formats are not supported.
+ *
+ * @param led_config LED strip configuration
+ * @param rmt_config RMT specific configuration
+ * @param pixel_fn Pixel generator
+ * @param user_ctx User context, passed to the pixel generator
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_rmt_generator(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                      led_strip_pixel_generator_t pixel_fn, void *user_ctx, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Type of LED strip group handle
+ */
+typedef struct led_strip_group_t *led_strip_group_handle_t;
+
+/**
+ * @brief Create a group of LED strips, each one on its own RMT TX channel, which are refreshed at the same time
+ *
+ * @note The strips of a group are started together by the RMT sync manager, if the chip supports it.
+ *       So the time of refreshing the group is the time of refreshing the longest strip, instead of the sum of all strips.
+ * @note Use `led_strip_group_get_strip` to get the handle of each strip and set its pixels as usual.
+ *       But the strips can only be refreshed (and cleared) by `led_strip_group_refresh`, and deleted by `led_strip_group_del`.
+ * @note The RMT channels are enabled when the group is created and stay enabled until it's deleted, as the sync manager
+ *       requires. So `led_strip_register_event_callbacks` can't be used on the strips of a group.
+ *
+ * @param led_configs Array of LED strip configurations, one for each strip
+ * @param rmt_config RMT specific configuration, shared by all strips
+ * @param num_strips Number of strips in the group
+ * @param ret_group Returned LED strip group handle
+ * @return
+ *      - ESP_OK: create LED strip group successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip group failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip group failed because of out of memory
+ *      - ESP_ERR_NOT_FOUND: create LED strip group failed because there are not enough free RMT channels
+ *      - ESP_FAIL: create LED strip group failed because some other error
+ */
+esp_err_t led_strip_new_rmt_group(const led_strip_config_t *led_configs, const led_strip_rmt_config_t *rmt_config, size_t num_strips, led_strip_group_handle_t *ret_group);
+
+/**
+ * @brief Get the handle of a strip in the group
+ *
+ * @param group LED strip group
+ * @param index Index of the strip, in the order of `led_configs` passed to `led_strip_new_rmt_group`
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: get LED strip successfully
+ *      - ESP_ERR_INVALID_ARG: get LED strip failed because of invalid argument
+ */
+esp_err_t led_strip_group_get_strip(led_strip_group_handle_t group, size_t index, led_strip_handle_t *ret_strip);
+
+/**
+ * @brief Refresh all strips of the group at the same time, and wait for all of them to be sent out
+ *
+ * @param group LED strip group
+ * @return
+ *      - ESP_OK: refresh LED strip group successfully
+ *      - ESP_ERR_INVALID_ARG: refresh LED strip group failed because of invalid argument
+ *      - ESP_FAIL: refresh LED strip group failed because some other error
+ */
+esp_err_t led_strip_group_refresh(led_strip_group_handle_t group);
+
+/**
+ * @brief Free the LED strip group, as well as all of its strips
+ *
+ * @param group LED strip group
+ * @return
+ *      - ESP_OK: free LED strip group successfully
+ *      - ESP_ERR_INVALID_ARG: free LED strip group failed because of invalid argument
+ *      - ESP_FAIL: free LED strip group failed because some other error
+ */
+esp_err_t led_strip_group_del(led_strip_group_handle_t group);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
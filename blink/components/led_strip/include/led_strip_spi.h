@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/spi_master.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED Strip SPI specific configuration
+ */
+typedef struct {
+    spi_clock_source_t clk_src; /*!< SPI clock source */
+    spi_host_device_t spi_bus;  /*!< SPI bus ID. Which buses are available depends on the specific chip */
+    uint32_t stream_chunk_leds; /*!< Set to non-zero to stream the pixels out in chunks of this many LEDs, see `led_strip_new_spi_device`.
+                                     A chunk must take longer on the wire (28.8 us per GRB LED) than the refreshing task can be held up,
+                                     or the line stays low between two chunks for longer than the reset time and the strip shows a partial frame */
+    int clk_gpio_num;           /*!< GPIO number of the clock line of the clocked LED models (APA102, SK9822), which must be set explicitly:
+                                     0 is rejected unless `flags.clk_on_gpio0` is set, as it's what a zero-initialized config holds.
+                                     Set to -1 for the other LED models, which have no clock line */
+    uint32_t clock_speed_hz;    /*!< SPI clock of the clocked LED models, set to zero to use the default 10MHz */
+    struct {
+        uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t clk_on_gpio0: 1; /*!< `clk_gpio_num` 0 is meant, the clock line is on GPIO0 */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_spi_config_t;
+
+/**
+ * @brief Create LED strip based on SPI MOSI channel
+ * @note Although only the MOSI line is used for generating the signal, the whole SPI bus can't be used for other purposes.
+ * @note The GRB(W) bytes are kept and encoded when the strip is refreshed. By default, they're encoded into the SPI waveform
+ *       of the whole strip (3 bytes per color byte), kept in DMA capable internal memory. When `stream_chunk_leds` is set,
+ *       they're encoded into two small DMA buffers of `stream_chunk_leds` LEDs each while the previous chunk is being sent out.
+ *       Streaming requires `flags.with_dma`.
+ * @note The clocked LED models (`LED_MODEL_APA102`, `LED_MODEL_SK9822`) also use the SCLK line, routed to `clk_gpio_num`,
+ *       which must be a valid GPIO (GPIO0 only with `flags.clk_on_gpio0`).
+ *       Their pixels are sent out as they are (4 bytes per LED, with a 5-bit brightness), at `clock_speed_hz`.
+ *       Only `LED_PIXEL_FORMAT_GRB` is supported for them, and `stream_chunk_leds` must be zero.
+ *
+ * @param led_config LED strip configuration
+ * @param spi_config SPI specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NOT_SUPPORTED: create LED strip handle failed because of unsupported configuration
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip);
+
+#ifdef __cplusplus
+}
+#endif
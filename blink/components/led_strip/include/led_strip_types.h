@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED strip pixel format
+ */
+typedef enum {
+    LED_PIXEL_FORMAT_GRB,    /*!< Pixel format: GRB */
+    LED_PIXEL_FORMAT_GRBW,   /*!< Pixel format: GRBW */
+    LED_PIXEL_FORMAT_INDEXED8, /*!< Pixel format: 8-bit index into a palette of 256 GRB colors */
+    LED_PIXEL_FORMAT_INDEXED4, /*!< Pixel format: 4-bit index into a palette of 16 GRB colors */
+    LED_PIXEL_FORMAT_INVALID /*!< Invalid pixel format */
+} led_pixel_format_t;
+
+/**
+ * @brief Layout of the color data passed to `led_strip_set_pixels`
+ */
+typedef enum {
+    LED_COLOR_FORMAT_RGB,    /*!< 3 bytes per pixel: R, G, B */
+    LED_COLOR_FORMAT_GRB,    /*!< 3 bytes per pixel: G, R, B, same as what the LED strip expects */
+    LED_COLOR_FORMAT_RGBW,   /*!< 4 bytes per pixel: R, G, B, W */
+    LED_COLOR_FORMAT_GRBW,   /*!< 4 bytes per pixel: G, R, B, W, same as what the LED strip expects */
+    LED_COLOR_FORMAT_INVALID /*!< Invalid color format */
+} led_color_format_t;
+
+/**
+ * @brief Color look-up tables, applied to each color component when the pixels are encoded
+ *
+ * @note Can be used for gamma correction and global brightness, e.g. `red[i] = gamma(i) * brightness`.
+ */
+typedef struct {
+    uint8_t red[256];   /*!< Output value of each red component value */
+    uint8_t green[256]; /*!< Output value of each green component value */
+    uint8_t blue[256];  /*!< Output value of each blue component value */
+    uint8_t white[256]; /*!< Output value of each white component value, only used by the LED strip with white component */
+} led_strip_color_lut_t;
+
+/**
+ * @brief LED strip model
+ * @note Different led model may have different timing parameters, so we need to distinguish them.
+ */
+typedef enum {
+    LED_MODEL_WS2812, /*!< LED strip model: WS2812 */
+    LED_MODEL_SK6812, /*!< LED strip model: SK6812 */
+    LED_MODEL_APA102, /*!< LED strip model: APA102, with clock and data lines, only supported by the SPI backend */
+    LED_MODEL_SK9822, /*!< LED strip model: SK9822, with clock and data lines, only supported by the SPI backend */
+    LED_MODEL_INVALID /*!< Invalid LED strip model */
+} led_model_t;
+
+/**
+ * @brief LED strip handle
+ */
+typedef struct led_strip_t *led_strip_handle_t;
+
+/**
+ * @brief Type of LED strip refresh done callback
+ *
+ * @param strip: LED strip whose frame has been completely sent out
+ * @param user_ctx: User registered context, passed from `led_strip_register_event_callbacks`
+ *
+ * @return Whether a high priority task has been waken up by this callback function
+ */
+typedef bool (*led_strip_refresh_done_cb_t)(led_strip_handle_t strip, void *user_ctx);
+
+/**
+ * @brief Type of LED strip pixel generator
+ *
+ * @note Called by the encoder for each pixel while the frame is being sent out, mostly from the ISR context.
+ *       So it must be fast and must not block. If `CONFIG_RMT_ISR_IRAM_SAFE` is enabled, it must be placed in IRAM.
+ *
+ * @param index: index of the pixel
+ * @param user_ctx: User registered context, passed from `led_strip_new_rmt_generator`
+ *
+ * @return Color of the pixel, packed in the order of the LED strip: `(green << 16) | (red << 8) | blue` for GRB strips,
+ *         `(green << 24) | (red << 16) | (blue << 8) | white` for GRBW strips
+ */
+typedef uint32_t (*led_strip_pixel_generator_t)(uint32_t index, void *user_ctx);
+
+/**
+ * @brief Group of supported LED strip event callbacks
+ * @note The callbacks are all running under ISR environment
+ */
+typedef struct {
+    led_strip_refresh_done_cb_t on_refresh_done; /*!< Invoked when a frame has been completely sent out */
+} led_strip_event_callbacks_t;
+
+/**
+ * @brief LED Strip Configuration
+ */
+typedef struct {
+    int strip_gpio_num;      /*!< GPIO number that used by LED strip */
+    uint32_t max_leds;       /*!< Maximum LEDs in a single strip */
+    led_pixel_format_t led_pixel_format; /*!< LED pixel format */
+    led_model_t led_model;   /*!< LED model */
+
+    struct {
+        uint32_t invert_out: 1; /*!< Invert output signal */
+    } flags;                    /*!< Extra driver flags */
+} led_strip_config_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct led_strip_t led_strip_t; /*!< Type of LED strip */
+
+/**
+ * @brief LED strip interface definition
+ */
+struct led_strip_t {
+    /**
+     * @brief Set RGB for a specific pixel
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     *
+     * @return
+     *      - ESP_OK: Set RGB for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGB for a specific pixel failed because of invalid parameters
+     *      - ESP_FAIL: Set RGB for a specific pixel failed because other error occurred
+     */
+    esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
+
+    /**
+     * @brief Set RGBW for a specific pixel. Similar to `set_pixel` but also set the white component
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     * @param white: separate white component
+     *
+     * @return
+     *      - ESP_OK: Set RGBW color for a specific pixel successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGBW color for a specific pixel failed because of an invalid argument
+     *      - ESP_FAIL: Set RGBW color for a specific pixel failed because other error occurred
+     */
+    esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+    /**
+     * @brief Set colors for a range of consecutive pixels
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param colors: color data, `count` pixels laid out as described by `format`
+     * @param format: layout of the color data
+     *
+     * @return
+     *      - ESP_OK: Set colors for the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set colors for the pixels failed because of invalid parameters
+     *      - ESP_FAIL: Set colors for the pixels failed because other error occurred
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format);
+
+    /**
+     * @brief Set color look-up tables, which are applied to the pixels when they're sent out
+     *
+     * @param strip: LED strip
+     * @param lut: color look-up tables, or NULL to disable them
+     *
+     * @return
+     *      - ESP_OK: Set color look-up tables successfully
+     *      - ESP_FAIL: Set color look-up tables failed because other error occurred
+     *
+     * @note:
+     *      Optional, a backend that leaves it NULL doesn't support color look-up tables.
+     */
+    esp_err_t (*set_color_lut)(led_strip_t *strip, const led_strip_color_lut_t *lut);
+
+    /**
+     * @brief Set the brightness of a specific pixel, for the LED models with a per-pixel brightness
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param brightness: brightness of the pixel
+     *
+     * @return
+     *      - ESP_OK: Set the brightness successfully
+     *      - ESP_ERR_INVALID_ARG: Set the brightness failed because of invalid argument
+     *      - ESP_FAIL: Set the brightness failed because other error occurred
+     *
+     * @note:
+     *      Optional, a backend that leaves it NULL doesn't support per-pixel brightness.
+     */
+    esp_err_t (*set_pixel_brightness)(led_strip_t *strip, uint32_t index, uint8_t brightness);
+
+    /**
+     * @brief Set the color of a palette entry, for the indexed pixel formats
+     *
+     * @param strip: LED strip
+     * @param palette_index: index of the palette entry
+     * @param red: red part of color
+     * @param green: green part of color
+     * @param blue: blue part of color
+     *
+     * @return
+     *      - ESP_OK: Set the palette color successfully
+     *      - ESP_ERR_INVALID_ARG: Set the palette color failed because of invalid argument
+     *      - ESP_FAIL: Set the palette color failed because other error occurred
+     *
+     * @note:
+     *      Optional, a backend that leaves it NULL doesn't support the indexed pixel formats.
+     */
+    esp_err_t (*set_palette_color)(led_strip_t *strip, uint32_t palette_index, uint32_t red, uint32_t green, uint32_t blue);
+
+    /**
+     * @brief Set the palette index of a specific pixel, for the indexed pixel formats
+     *
+     * @param strip: LED strip
+     * @param index: index of pixel to set
+     * @param palette_index: index of the palette entry
+     *
+     * @return
+     *      - ESP_OK: Set the palette index successfully
+     *      - ESP_ERR_INVALID_ARG: Set the palette index failed because of invalid argument
+     *      - ESP_FAIL: Set the palette index failed because other error occurred
+     *
+     * @note:
+     *      Optional, a backend that leaves it NULL doesn't support the indexed pixel formats.
+     */
+    esp_err_t (*set_pixel_index)(led_strip_t *strip, uint32_t index, uint32_t palette_index);
+
+    /**
+     * @brief Refresh memory colors to LEDs
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for refreshing task
+     *
+     * @return
+     *      - ESP_OK: Refresh successfully
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     *
+     * @note:
+     *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+     */
+    esp_err_t (*refresh)(led_strip_t *strip);
+
+    /**
+     * @brief Start flushing memory colors to LEDs, return without waiting for the transmission to finish
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Start refreshing successfully
+     *      - ESP_FAIL: Start refreshing failed because some other error occurred
+     *
+     * @note:
+     *      Optional, a backend that leaves it NULL doesn't support asynchronous refresh.
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip);
+
+    /**
+     * @brief Wait for the frame started by `refresh_async` to be completely sent out
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: Wait timeout, in ms. Specially, -1 means to wait forever
+     *
+     * @return
+     *      - ESP_OK: All pending frames have been sent out
+     *      - ESP_ERR_TIMEOUT: The frame is still being sent out when the timeout expired
+     *      - ESP_FAIL: Wait failed because some other error occurred
+     */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, int timeout_ms);
+
+    /**
+     * @brief Set callbacks for LED strip events
+     *
+     * @param strip: LED strip
+     * @param cbs: Group of callback functions
+     * @param user_ctx: User data, which will be passed to the callback functions directly
+     *
+     * @return
+     *      - ESP_OK: Set event callbacks successfully
+     *      - ESP_FAIL: Set event callbacks failed because some other error occurred
+     */
+    esp_err_t (*register_event_callbacks)(led_strip_t *strip, const led_strip_event_callbacks_t *cbs, void *user_ctx);
+
+    /**
+     * @brief Clear LED strip (turn off all LEDs)
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value for clearing task
+     *
+     * @return
+     *      - ESP_OK: Clear LEDs successfully
+     *      - ESP_FAIL: Clear LEDs failed because some other error occurred
+     */
+    esp_err_t (*clear)(led_strip_t *strip);
+
+    /**
+     * @brief Free LED strip resources
+     *
+     * @param strip: LED strip
+     *
+     * @return
+     *      - ESP_OK: Free resources successfully
+     *      - ESP_FAIL: Free resources failed because error occurred
+     */
+    esp_err_t (*del)(led_strip_t *strip);
+};
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "led_strip.h"
+#include "led_strip_mock.h"
+#include "led_strip_interface.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_pixel_format.h"
+
+#define LED_STRIP_MOCK_DEFAULT_RESOLUTION 10000000 // 10MHz resolution, same as the RMT backend
+
+static const char *TAG = "led_strip_mock";
+
+// same layout as rmt_symbol_word_t, which is not available on the host
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} led_strip_mock_symbol_t;
+
+typedef struct {
+    led_strip_t base;
+    led_strip_mock_sink_t sink;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    led_strip_mock_symbol_t bit0;       // RMT symbol of a 0 bit
+    led_strip_mock_symbol_t bit1;       // RMT symbol of a 1 bit
+    led_strip_mock_symbol_t reset_code; // RMT symbol sent after the pixels
+    const uint8_t *lut[4];              // look-up table of each component in the order of G, R, B, W, or NULL if not enabled
+    led_strip_refresh_done_cb_t on_refresh_done;
+    void *user_ctx;
+    uint8_t *sink_buf;                  // waveform of the last frame sent out
+    size_t sink_size;                   // size of the waveform of the last frame sent out, 0 if none was sent yet
+    bool tx_pending;                    // tx_buf holds a frame that is "on the wire", it's encoded when waited for
+    uint8_t *tx_buf;                    // snapshot of pixel_buf that is being sent out, so the next frame can be rendered meanwhile
+    uint8_t pixel_buf[];
+} led_strip_mock_obj;
+
+static esp_err_t led_strip_mock_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    ESP_RETURN_ON_FALSE(index < mock_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    uint8_t *pixel = mock_strip->pixel_buf + index * mock_strip->bytes_per_pixel;
+    pixel[0] = green & 0xFF;
+    pixel[1] = red & 0xFF;
+    pixel[2] = blue & 0xFF;
+    if (mock_strip->bytes_per_pixel > 3) {
+        pixel[3] = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_mock_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    ESP_RETURN_ON_FALSE(index < mock_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(mock_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    uint8_t *pixel = mock_strip->pixel_buf + index * 4;
+    pixel[0] = green & 0xFF;
+    pixel[1] = red & 0xFF;
+    pixel[2] = blue & 0xFF;
+    pixel[3] = white & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_mock_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    ESP_RETURN_ON_FALSE(start <= mock_strip->strip_len && count <= mock_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(led_strip_color_format_bytes(format) <= mock_strip->bytes_per_pixel, ESP_ERR_INVALID_ARG, TAG,
+                        "color format has a white component but the strip has none");
+    led_strip_pixel_reorder(mock_strip->pixel_buf + start * mock_strip->bytes_per_pixel, LED_STRIP_PIXEL_LAYOUT_GRB(mock_strip->bytes_per_pixel), colors, count, format);
+    return ESP_OK;
+}
+
+static void led_strip_mock_send_frame(led_strip_mock_obj *mock_strip);
+
+static esp_err_t led_strip_mock_set_color_lut(led_strip_t *strip, const led_strip_color_lut_t *lut)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    // the look-up tables are read while the frame is sent out
+    led_strip_mock_send_frame(mock_strip);
+    if (lut) {
+        mock_strip->lut[0] = lut->green;
+        mock_strip->lut[1] = lut->red;
+        mock_strip->lut[2] = lut->blue;
+        mock_strip->lut[3] = lut->white;
+    } else {
+        memset(mock_strip->lut, 0, sizeof(mock_strip->lut));
+    }
+    return ESP_OK;
+}
+
+// Encode the pending frame into the sink, which is when the frame is done on the wire for the mock
+static void led_strip_mock_send_frame(led_strip_mock_obj *mock_strip)
+{
+    if (!mock_strip->tx_pending) {
+        return;
+    }
+    size_t frame_size = mock_strip->strip_len * mock_strip->bytes_per_pixel;
+    if (mock_strip->sink == LED_STRIP_MOCK_SINK_RMT) {
+        // one symbol per bit, MSB first, followed by the reset code
+        led_strip_mock_symbol_t *symbols = (led_strip_mock_symbol_t *)mock_strip->sink_buf;
+        for (size_t i = 0; i < frame_size; i++) {
+            uint8_t data = mock_strip->tx_buf[i];
+            if (mock_strip->lut[0]) {
+                data = mock_strip->lut[i % mock_strip->bytes_per_pixel][data];
+            }
+            for (int bit = 7; bit >= 0; bit--) {
+                *symbols++ = (data >> bit) & 0x01 ? mock_strip->bit1 : mock_strip->bit0;
+            }
+        }
+        *symbols++ = mock_strip->reset_code;
+        mock_strip->sink_size = (uint8_t *)symbols - mock_strip->sink_buf;
+    } else {
+        uint8_t *buf = mock_strip->sink_buf;
+        for (size_t i = 0; i < frame_size; i++) {
+            uint8_t data = mock_strip->tx_buf[i];
+            if (mock_strip->lut[0]) {
+                data = mock_strip->lut[i % mock_strip->bytes_per_pixel][data];
+            }
+            led_strip_spi_encode_byte(data, buf);
+            buf += LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+        }
+        mock_strip->sink_size = buf - mock_strip->sink_buf;
+    }
+    mock_strip->tx_pending = false;
+    if (mock_strip->on_refresh_done) {
+        mock_strip->on_refresh_done(&mock_strip->base, mock_strip->user_ctx);
+    }
+}
+
+static esp_err_t led_strip_mock_refresh_async(led_strip_t *strip)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    // the previous frame is still read from tx_buf, finish it before taking the new snapshot
+    led_strip_mock_send_frame(mock_strip);
+    memcpy(mock_strip->tx_buf, mock_strip->pixel_buf, mock_strip->strip_len * mock_strip->bytes_per_pixel);
+    mock_strip->tx_pending = true;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_mock_wait_refresh_done(led_strip_t *strip, int timeout_ms)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    led_strip_mock_send_frame(mock_strip);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_mock_refresh(led_strip_t *strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_mock_refresh_async(strip), TAG, "refresh LED strip failed");
+    return led_strip_mock_wait_refresh_done(strip, -1);
+}
+
+static esp_err_t led_strip_mock_register_event_callbacks(led_strip_t *strip, const led_strip_event_callbacks_t *cbs, void *user_ctx)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    led_strip_mock_send_frame(mock_strip);
+    mock_strip->on_refresh_done = cbs->on_refresh_done;
+    mock_strip->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_mock_clear(led_strip_t *strip)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    // Write zero to turn off all leds
+    memset(mock_strip->pixel_buf, 0, mock_strip->strip_len * mock_strip->bytes_per_pixel);
+    return led_strip_mock_refresh(strip);
+}
+
+static esp_err_t led_strip_mock_del(led_strip_t *strip)
+{
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    free(mock_strip->sink_buf);
+    free(mock_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_mock_get_sink(led_strip_handle_t strip, const void **ret_data, size_t *ret_size)
+{
+    ESP_RETURN_ON_FALSE(strip && ret_data && ret_size, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(strip->del == led_strip_mock_del, ESP_ERR_INVALID_ARG, TAG, "not a mock LED strip");
+    led_strip_mock_obj *mock_strip = __containerof(strip, led_strip_mock_obj, base);
+    *ret_data = mock_strip->sink_buf;
+    *ret_size = mock_strip->sink_size;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_mock_device(const led_strip_config_t *led_config, const led_strip_mock_config_t *mock_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_mock_obj *mock_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && mock_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(mock_config->sink < LED_STRIP_MOCK_SINK_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid sink");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB || led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW,
+                      ESP_ERR_NOT_SUPPORTED, err, TAG, "indexed pixel format is not supported");
+    ESP_GOTO_ON_FALSE(led_config->led_model == LED_MODEL_WS2812 || led_config->led_model == LED_MODEL_SK6812,
+                      ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported led model");
+    uint8_t bytes_per_pixel = led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW ? 4 : 3;
+    size_t frame_size = led_config->max_leds * bytes_per_pixel;
+    // one buffer for rendering the next frame and one for the frame being sent out
+    mock_strip = calloc(1, sizeof(led_strip_mock_obj) + frame_size * 2);
+    ESP_GOTO_ON_FALSE(mock_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for mock strip");
+    mock_strip->tx_buf = mock_strip->pixel_buf + frame_size;
+    size_t sink_buf_size = frame_size * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE;
+    if (mock_config->sink == LED_STRIP_MOCK_SINK_RMT) {
+        sink_buf_size = (frame_size * 8 + 1) * sizeof(led_strip_mock_symbol_t);
+    }
+    mock_strip->sink_buf = calloc(1, sink_buf_size);
+    ESP_GOTO_ON_FALSE(mock_strip->sink_buf, ESP_ERR_NO_MEM, err, TAG, "no mem for sink");
+
+    // same timing as the RMT backend encoder
+    uint32_t resolution = mock_config->resolution_hz ? mock_config->resolution_hz : LED_STRIP_MOCK_DEFAULT_RESOLUTION;
+    uint32_t t0h_ns = 300, t0l_ns = 900, t1h_ns = 900, t1l_ns = 300;
+    if (led_config->led_model == LED_MODEL_SK6812) {
+        t1h_ns = 600;
+        t1l_ns = 600;
+    }
+    mock_strip->bit0 = (led_strip_mock_symbol_t) {
+        .level0 = 1,
+        .duration0 = (uint64_t)resolution * t0h_ns / 1000000000,
+        .level1 = 0,
+        .duration1 = (uint64_t)resolution * t0l_ns / 1000000000,
+    };
+    mock_strip->bit1 = (led_strip_mock_symbol_t) {
+        .level0 = 1,
+        .duration0 = (uint64_t)resolution * t1h_ns / 1000000000,
+        .level1 = 0,
+        .duration1 = (uint64_t)resolution * t1l_ns / 1000000000,
+    };
+    uint32_t reset_ticks = resolution / 1000000 * 280 / 2; // 280us, same as the RMT backend
+    mock_strip->reset_code = (led_strip_mock_symbol_t) {
+        .level0 = 0,
+        .duration0 = reset_ticks,
+        .level1 = 0,
+        .duration1 = reset_ticks,
+    };
+
+    mock_strip->sink = mock_config->sink;
+    mock_strip->bytes_per_pixel = bytes_per_pixel;
+    mock_strip->strip_len = led_config->max_leds;
+    mock_strip->base.set_pixel = led_strip_mock_set_pixel;
+    mock_strip->base.set_pixel_rgbw = led_strip_mock_set_pixel_rgbw;
+    mock_strip->base.set_pixels = led_strip_mock_set_pixels;
+    mock_strip->base.set_color_lut = led_strip_mock_set_color_lut;
+    mock_strip->base.refresh = led_strip_mock_refresh;
+    mock_strip->base.refresh_async = led_strip_mock_refresh_async;
+    mock_strip->base.wait_refresh_done = led_strip_mock_wait_refresh_done;
+    mock_strip->base.register_event_callbacks = led_strip_mock_register_event_callbacks;
+    mock_strip->base.clear = led_strip_mock_clear;
+    mock_strip->base.del = led_strip_mock_del;
+
+    *ret_strip = &mock_strip->base;
+    return ESP_OK;
+err:
+    if (mock_strip) {
+        free(mock_strip->sink_buf);
+        free(mock_strip);
+    }
+    return ret;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LED_STRIP_PIXEL_NO_WHITE 0xFF /*!< Position of the white component of a pixel that has none */
+
+/**
+ * @brief Position of each color component within a pixel of the LED strip's buffer
+ */
+typedef struct {
+    uint8_t size;  /*!< Bytes per pixel */
+    uint8_t green; /*!< Position of the green component */
+    uint8_t red;   /*!< Position of the red component */
+    uint8_t blue;  /*!< Position of the blue component */
+    uint8_t white; /*!< Position of the white component, LED_STRIP_PIXEL_NO_WHITE if there's none */
+} led_strip_pixel_layout_t;
+
+/**
+ * @brief Layout of the GRB(W) pixels sent out by WS2812 and SK6812, which have 3 or 4 bytes per pixel
+ */
+#define LED_STRIP_PIXEL_LAYOUT_GRB(bytes_per_pixel) ((led_strip_pixel_layout_t) { \
+    .size = (bytes_per_pixel), .green = 0, .red = 1, .blue = 2,                  \
+    .white = (bytes_per_pixel) > 3 ? 3 : LED_STRIP_PIXEL_NO_WHITE,               \
+})
+
+/**
+ * @brief Number of bytes per pixel of a color format
+ */
+static inline uint8_t led_strip_color_format_bytes(led_color_format_t format)
+{
+    return (format == LED_COLOR_FORMAT_RGBW || format == LED_COLOR_FORMAT_GRBW) ? 4 : 3;
+}
+
+/**
+ * @brief Copy pixels into the LED strip's buffer, reordering their components
+ *
+ * @note The white component is set to zero if the colors have none. Bytes of the pixel that are not
+ *       in the layout (e.g. the brightness of APA102) are kept.
+ *
+ * @param dst First pixel to set in the buffer
+ * @param layout Layout of the pixels in the buffer
+ * @param colors Color data, `count` pixels laid out as described by `format`
+ * @param count Number of pixels
+ * @param format Layout of the color data
+ */
+static inline void led_strip_pixel_reorder(uint8_t *dst, led_strip_pixel_layout_t layout, const uint8_t *colors, uint32_t count,
+                                           led_color_format_t format)
+{
+    uint8_t src_bytes = led_strip_color_format_bytes(format);
+    if ((format == LED_COLOR_FORMAT_GRB || format == LED_COLOR_FORMAT_GRBW) && src_bytes == layout.size &&
+            layout.green == 0 && layout.red == 1 && layout.blue == 2) {
+        // the colors are already in the order of the LED strip
+        memcpy(dst, colors, count * src_bytes);
+        return;
+    }
+    uint8_t red_pos = (format == LED_COLOR_FORMAT_RGB || format == LED_COLOR_FORMAT_RGBW) ? 0 : 1;
+    uint8_t green_pos = 1 - red_pos;
+    for (uint32_t i = 0; i < count; i++) {
+        dst[layout.green] = colors[green_pos];
+        dst[layout.red] = colors[red_pos];
+        dst[layout.blue] = colors[2];
+        if (layout.white != LED_STRIP_PIXEL_NO_WHITE) {
+            dst[layout.white] = src_bytes > 3 ? colors[3] : 0;
+        }
+        colors += src_bytes;
+        dst += layout.size;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,469 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "driver/rmt_tx.h"
+#include "soc/soc_caps.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_rmt_encoder.h"
+#include "led_strip_pixel_format.h"
+
+#define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
+#define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
+// the memory size of each RMT channel, in words (4 bytes)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 64
+#else
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 48
+#endif
+
+static const char *TAG = "led_strip_rmt";
+
+typedef struct {
+    led_strip_t base;
+    rmt_channel_handle_t rmt_chan;
+    rmt_encoder_handle_t strip_encoder;
+    led_strip_refresh_done_cb_t on_refresh_done;
+    void *user_ctx;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    size_t frame_size;  // size of pixel_buf, the pixels are packed when the pixel format is indexed
+    uint32_t palette_len; // number of palette entries, 0 if the pixel format is not indexed
+    uint8_t *palette;   // GRB palette entries of the indexed pixel formats
+    uint8_t *tx_palette; // snapshot of the palette that is being sent out
+    led_strip_pixel_generator_t pixel_fn; // generates the pixels while they're sent out, there's no pixel buffer then
+    void *pixel_ctx;
+    bool enabled;       // the RMT channel is kept enabled between frames
+    bool in_group;      // the strip is refreshed by a led_strip_group_t
+    uint8_t *tx_buf;    // snapshot of pixel_buf that is being sent out, so the next frame can be rendered meanwhile
+    uint8_t pixel_buf[];
+} led_strip_rmt_obj;
+
+struct led_strip_group_t {
+    rmt_sync_manager_handle_t synchro; // NULL if the chip can't start RMT channels synchronously
+    size_t num_strips;
+    led_strip_rmt_obj *strips[];
+};
+
+static bool IRAM_ATTR led_strip_rmt_trans_done_cb(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    return rmt_strip->on_refresh_done(&rmt_strip->base, rmt_strip->user_ctx);
+}
+
+static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(!rmt_strip->palette_len, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, use palette index instead");
+    uint32_t start = index * rmt_strip->bytes_per_pixel;
+    // In thr order of GRB, as LED strip like WS2812 sends out pixels in this order
+    rmt_strip->pixel_buf[start + 0] = green & 0xFF;
+    rmt_strip->pixel_buf[start + 1] = red & 0xFF;
+    rmt_strip->pixel_buf[start + 2] = blue & 0xFF;
+    if (rmt_strip->bytes_per_pixel > 3) {
+        rmt_strip->pixel_buf[start + 3] = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    uint8_t *buf_start = rmt_strip->pixel_buf + index * 4;
+    // SK6812 component order is GRBW
+    *buf_start = green & 0xFF;
+    *++buf_start = red & 0xFF;
+    *++buf_start = blue & 0xFF;
+    *++buf_start = white & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(!rmt_strip->palette_len, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, use palette index instead");
+    ESP_RETURN_ON_FALSE(led_strip_color_format_bytes(format) <= rmt_strip->bytes_per_pixel, ESP_ERR_INVALID_ARG, TAG,
+                        "color format has a white component but the strip has none");
+    led_strip_pixel_reorder(rmt_strip->pixel_buf + start * rmt_strip->bytes_per_pixel, LED_STRIP_PIXEL_LAYOUT_GRB(rmt_strip->bytes_per_pixel), colors, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_palette_color(led_strip_t *strip, uint32_t palette_index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(palette_index < rmt_strip->palette_len, ESP_ERR_INVALID_ARG, TAG, "palette index out of range");
+    uint8_t *entry = rmt_strip->palette + palette_index * 3;
+    entry[0] = green & 0xFF;
+    entry[1] = red & 0xFF;
+    entry[2] = blue & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_index(led_strip_t *strip, uint32_t index, uint32_t palette_index)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(palette_index < rmt_strip->palette_len, ESP_ERR_INVALID_ARG, TAG, "palette index out of range");
+    if (rmt_strip->palette_len > 16) {
+        rmt_strip->pixel_buf[index] = palette_index;
+    } else {
+        // two pixels per byte, the first one in the high nibble
+        uint8_t shift = index & 1 ? 0 : 4;
+        uint8_t *byte = &rmt_strip->pixel_buf[index / 2];
+        *byte = (*byte & ~(0x0F << shift)) | (palette_index << shift);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_start_frame(led_strip_rmt_obj *rmt_strip)
+{
+    size_t frame_size = rmt_strip->frame_size;
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+
+    if (!rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
+    // the previous frame is still read from tx_buf by the encoder, wait for it before taking the new snapshot
+    ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    memcpy(rmt_strip->tx_buf, rmt_strip->pixel_buf, frame_size);
+    if (rmt_strip->palette_len) {
+        memcpy(rmt_strip->tx_palette, rmt_strip->palette, rmt_strip->palette_len * 3);
+    }
+    if (rmt_strip->palette_len || rmt_strip->pixel_fn) {
+        // the encoder of the indexed pixel formats and the generator takes the number of pixels
+        frame_size = rmt_strip->strip_len;
+    }
+    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->tx_buf,
+                                     frame_size, &tx_conf), TAG, "transmit pixels by RMT failed");
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(!rmt_strip->in_group, ESP_ERR_INVALID_STATE, TAG, "strip belongs to a group, refresh the group instead");
+    return led_strip_rmt_start_frame(rmt_strip);
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (!rmt_strip->enabled) {
+        // nothing has been sent out yet
+        return ESP_OK;
+    }
+    return rmt_tx_wait_all_done(rmt_strip->rmt_chan, timeout_ms);
+}
+
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_async(strip), TAG, "refresh LED strip failed");
+    ESP_RETURN_ON_ERROR(led_strip_rmt_wait_refresh_done(strip, -1), TAG, "flush RMT channel failed");
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_register_event_callbacks(led_strip_t *strip, const led_strip_event_callbacks_t *cbs, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // the channels of a group stay enabled for their sync manager, so their callbacks can't be changed
+    ESP_RETURN_ON_FALSE(!rmt_strip->in_group, ESP_ERR_INVALID_STATE, TAG, "strip belongs to a group, callbacks can't be changed");
+    // RMT event callbacks can only be changed while the channel is disabled
+    if (rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+        rmt_strip->enabled = false;
+    }
+    rmt_strip->on_refresh_done = cbs->on_refresh_done;
+    rmt_strip->user_ctx = user_ctx;
+    rmt_tx_event_callbacks_t rmt_cbs = {
+        .on_trans_done = cbs->on_refresh_done ? led_strip_rmt_trans_done_cb : NULL,
+    };
+    ESP_RETURN_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &rmt_cbs, rmt_strip), TAG, "register RMT callbacks failed");
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_color_lut(led_strip_t *strip, const led_strip_color_lut_t *lut)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // the encoder reads the look-up tables while the frame is sent out
+    if (rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    }
+    return rmt_led_strip_encoder_set_lut(rmt_strip->strip_encoder, lut);
+}
+
+static esp_err_t led_strip_rmt_generated_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    ESP_LOGE(TAG, "pixels are generated by the callback");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static esp_err_t led_strip_rmt_generated_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_LOGE(TAG, "pixels are generated by the callback");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static uint32_t IRAM_ATTR led_strip_rmt_black_pixel(uint32_t index, void *user_ctx)
+{
+    return 0;
+}
+
+static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->pixel_fn) {
+        // there's no pixel buffer, generate a black frame instead
+        esp_err_t ret = ESP_OK;
+        ESP_RETURN_ON_ERROR(led_strip_rmt_wait_refresh_done(strip, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_set_generator(rmt_strip->strip_encoder, led_strip_rmt_black_pixel, NULL), TAG, "set pixel generator failed");
+        ret = led_strip_rmt_refresh(strip);
+        rmt_led_strip_encoder_set_generator(rmt_strip->strip_encoder, rmt_strip->pixel_fn, rmt_strip->pixel_ctx);
+        return ret;
+    }
+    // Write zero to turn off all leds, or to show the palette entry 0 for the indexed pixel formats
+    memset(rmt_strip->pixel_buf, 0, rmt_strip->frame_size);
+    return led_strip_rmt_refresh(strip);
+}
+
+static esp_err_t led_strip_rmt_del(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(!rmt_strip->in_group, ESP_ERR_INVALID_STATE, TAG, "strip belongs to a group, delete the group instead");
+    if (rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
+    ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    free(rmt_strip);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_new_strip(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                         led_strip_pixel_generator_t pixel_fn, void *user_ctx, led_strip_handle_t *ret_strip)
+{
+    led_strip_rmt_obj *rmt_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && rmt_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    uint8_t bytes_per_pixel = 3;
+    uint32_t palette_len = 0;
+    size_t frame_size = 0;
+    if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
+        bytes_per_pixel = 4;
+        frame_size = led_config->max_leds * bytes_per_pixel;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
+        bytes_per_pixel = 3;
+        frame_size = led_config->max_leds * bytes_per_pixel;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_INDEXED8) {
+        palette_len = 256;
+        frame_size = led_config->max_leds;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_INDEXED4) {
+        palette_len = 16;
+        frame_size = (led_config->max_leds + 1) / 2;
+    } else {
+        assert(false);
+    }
+    if (pixel_fn) {
+        ESP_GOTO_ON_FALSE(!palette_len, ESP_ERR_INVALID_ARG, err, TAG, "indexed pixel format can't be generated");
+        // the pixels are generated while they're encoded, no pixel buffer is needed
+        frame_size = 0;
+    }
+    // one buffer for rendering the next frame and one for the frame being sent out, same for the palette
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + frame_size * 2 + palette_len * 3 * 2);
+    ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    rmt_strip->tx_buf = rmt_strip->pixel_buf + frame_size;
+    if (palette_len) {
+        rmt_strip->palette = rmt_strip->tx_buf + frame_size;
+        rmt_strip->tx_palette = rmt_strip->palette + palette_len * 3;
+    }
+    uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    rmt_clock_source_t clk_src = RMT_CLK_SRC_DEFAULT;
+    if (rmt_config->clk_src) {
+        clk_src = rmt_config->clk_src;
+    }
+    size_t mem_block_symbols = LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS;
+    // override the default value if the user sets it
+    if (rmt_config->mem_block_symbols) {
+        mem_block_symbols = rmt_config->mem_block_symbols;
+    }
+    rmt_tx_channel_config_t rmt_chan_config = {
+        .clk_src = clk_src,
+        .gpio_num = led_config->strip_gpio_num,
+        .mem_block_symbols = mem_block_symbols,
+        .resolution_hz = resolution,
+        .trans_queue_depth = LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE,
+        .flags.with_dma = rmt_config->flags.with_dma,
+        .flags.invert_out = led_config->flags.invert_out,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&rmt_chan_config, &rmt_strip->rmt_chan), err, TAG, "create RMT TX channel failed");
+
+    led_strip_encoder_config_t strip_encoder_conf = {
+        .resolution = resolution,
+        .led_model = led_config->led_model,
+        .led_pixel_format = led_config->led_pixel_format,
+        .palette = rmt_strip->tx_palette,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+    if (pixel_fn) {
+        ESP_GOTO_ON_ERROR(rmt_led_strip_encoder_set_generator(rmt_strip->strip_encoder, pixel_fn, user_ctx), err, TAG, "set pixel generator failed");
+    }
+
+
+    rmt_strip->bytes_per_pixel = bytes_per_pixel;
+    rmt_strip->frame_size = frame_size;
+    rmt_strip->palette_len = palette_len;
+    rmt_strip->strip_len = led_config->max_leds;
+    rmt_strip->pixel_fn = pixel_fn;
+    rmt_strip->pixel_ctx = user_ctx;
+    if (pixel_fn) {
+        rmt_strip->base.set_pixel = led_strip_rmt_generated_set_pixel;
+        rmt_strip->base.set_pixel_rgbw = led_strip_rmt_generated_set_pixel_rgbw;
+    } else {
+        rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+        rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+        rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    }
+    rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+    rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
+    rmt_strip->base.register_event_callbacks = led_strip_rmt_register_event_callbacks;
+    rmt_strip->base.set_color_lut = led_strip_rmt_set_color_lut;
+    if (palette_len) {
+        rmt_strip->base.set_palette_color = led_strip_rmt_set_palette_color;
+        rmt_strip->base.set_pixel_index = led_strip_rmt_set_pixel_index;
+    }
+    rmt_strip->base.clear = led_strip_rmt_clear;
+    rmt_strip->base.del = led_strip_rmt_del;
+
+    *ret_strip = &rmt_strip->base;
+    return ESP_OK;
+err:
+    if (rmt_strip) {
+        if (rmt_strip->rmt_chan) {
+            rmt_del_channel(rmt_strip->rmt_chan);
+        }
+        if (rmt_strip->strip_encoder) {
+            rmt_del_encoder(rmt_strip->strip_encoder);
+        }
+        free(rmt_strip);
+    }
+    return ret;
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip)
+{
+    return led_strip_rmt_new_strip(led_config, rmt_config, NULL, NULL, ret_strip);
+}
+
+esp_err_t led_strip_new_rmt_generator(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config,
+                                      led_strip_pixel_generator_t pixel_fn, void *user_ctx, led_strip_handle_t *ret_strip)
+{
+    ESP_RETURN_ON_FALSE(pixel_fn, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    return led_strip_rmt_new_strip(led_config, rmt_config, pixel_fn, user_ctx, ret_strip);
+}
+
+esp_err_t led_strip_new_rmt_group(const led_strip_config_t *led_configs, const led_strip_rmt_config_t *rmt_config, size_t num_strips, led_strip_group_handle_t *ret_group)
+{
+    led_strip_group_handle_t group = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_configs && rmt_config && num_strips && ret_group, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    group = calloc(1, sizeof(struct led_strip_group_t) + num_strips * sizeof(led_strip_rmt_obj *));
+    ESP_GOTO_ON_FALSE(group, ESP_ERR_NO_MEM, err, TAG, "no mem for strip group");
+    for (size_t i = 0; i < num_strips; i++) {
+        led_strip_handle_t strip = NULL;
+        ESP_GOTO_ON_ERROR(led_strip_new_rmt_device(&led_configs[i], rmt_config, &strip), err, TAG, "create strip %zu failed", i);
+        group->strips[i] = __containerof(strip, led_strip_rmt_obj, base);
+        group->num_strips++;
+    }
+    // the sync manager can only be created on enabled channels, they're kept enabled as long as the group exists
+    for (size_t i = 0; i < num_strips; i++) {
+        ESP_GOTO_ON_ERROR(rmt_enable(group->strips[i]->rmt_chan), err, TAG, "enable RMT channel %zu failed", i);
+        group->strips[i]->enabled = true;
+    }
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    rmt_channel_handle_t *channels = calloc(num_strips, sizeof(rmt_channel_handle_t));
+    ESP_GOTO_ON_FALSE(channels, ESP_ERR_NO_MEM, err, TAG, "no mem for channel array");
+    for (size_t i = 0; i < num_strips; i++) {
+        channels[i] = group->strips[i]->rmt_chan;
+    }
+    rmt_sync_manager_config_t synchro_config = {
+        .tx_channel_array = channels,
+        .array_size = num_strips,
+    };
+    ret = rmt_new_sync_manager(&synchro_config, &group->synchro);
+    free(channels);
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "create sync manager failed");
+#endif
+    for (size_t i = 0; i < num_strips; i++) {
+        group->strips[i]->in_group = true;
+    }
+    *ret_group = group;
+    return ESP_OK;
+err:
+    if (group) {
+        for (size_t i = 0; i < group->num_strips; i++) {
+            led_strip_rmt_del(&group->strips[i]->base);
+        }
+        free(group);
+    }
+    return ret;
+}
+
+esp_err_t led_strip_group_get_strip(led_strip_group_handle_t group, size_t index, led_strip_handle_t *ret_strip)
+{
+    ESP_RETURN_ON_FALSE(group && ret_strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(index < group->num_strips, ESP_ERR_INVALID_ARG, TAG, "index out of number of strips");
+    *ret_strip = &group->strips[index]->base;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_refresh(led_strip_group_handle_t group)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (group->synchro) {
+        // the previous frames are done (they've been waited for below), rearm the sync manager for the next start
+        ESP_RETURN_ON_ERROR(rmt_sync_reset(group->synchro), TAG, "reset sync manager failed");
+    }
+    // with the sync manager, no channel starts before all of them have got their frame
+    for (size_t i = 0; i < group->num_strips; i++) {
+        ESP_RETURN_ON_ERROR(led_strip_rmt_start_frame(group->strips[i]), TAG, "refresh strip %zu failed", i);
+    }
+    for (size_t i = 0; i < group->num_strips; i++) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(group->strips[i]->rmt_chan, -1), TAG, "flush RMT channel failed");
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_group_del(led_strip_group_handle_t group)
+{
+    ESP_RETURN_ON_FALSE(group, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (group->synchro) {
+        ESP_RETURN_ON_ERROR(rmt_del_sync_manager(group->synchro), TAG, "delete sync manager failed");
+    }
+    for (size_t i = 0; i < group->num_strips; i++) {
+        group->strips[i]->in_group = false;
+        ESP_RETURN_ON_ERROR(led_strip_rmt_del(&group->strips[i]->base), TAG, "delete strip %zu failed", i);
+    }
+    free(group);
+    return ESP_OK;
+}
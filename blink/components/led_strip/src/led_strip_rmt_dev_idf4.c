@@ -11,6 +11,7 @@
 #include "driver/rmt.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
+#include "led_strip_pixel_format.h"
 
 static const char *TAG = "led_strip_rmt";
 
@@ -93,6 +94,17 @@ static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uin
     return ESP_OK;
 }
 
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(led_strip_color_format_bytes(format) <= rmt_strip->bytes_per_pixel, ESP_ERR_INVALID_ARG, TAG,
+                        "color format has a white component but the strip has none");
+    led_strip_pixel_reorder(rmt_strip->buffer + start * rmt_strip->bytes_per_pixel, LED_STRIP_PIXEL_LAYOUT_GRB(rmt_strip->bytes_per_pixel), colors, count, format);
+    return ESP_OK;
+}
+
 static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
@@ -125,6 +137,7 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     ESP_RETURN_ON_FALSE(led_config && dev_config && ret_strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     ESP_RETURN_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, TAG, "invalid led_pixel_format");
     ESP_RETURN_ON_FALSE(dev_config->flags.with_dma == 0, ESP_ERR_NOT_SUPPORTED, TAG, "DMA is not supported");
+    ESP_RETURN_ON_FALSE(led_config->led_model == LED_MODEL_WS2812 || led_config->led_model == LED_MODEL_SK6812, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported led model");
 
     uint8_t bytes_per_pixel = 3;
     if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
@@ -132,7 +145,7 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
         bytes_per_pixel = 3;
     } else {
-        assert(false);
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, TAG, "indexed pixel format is not supported");
     }
 
     // allocate memory for led_strip object
@@ -179,6 +192,7 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
     rmt_strip->rmt_channel = (rmt_channel_t)dev_config->rmt_channel;
     rmt_strip->strip_len = led_config->max_leds;
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_check.h"
+#include "led_strip_rmt_encoder.h"
+
+static const char *TAG = "led_rmt_encoder";
+
+// Pixels are translated into the staging buffer this many bytes at a time, a multiple of both 3 and 4 bytes per pixel
+#define LED_STRIP_ENCODER_STAGING_SIZE 48
+
+typedef struct {
+    rmt_encoder_t base;
+    rmt_encoder_t *bytes_encoder;
+    rmt_encoder_t *copy_encoder;
+    int state;
+    rmt_symbol_word_t reset_code;
+    led_pixel_format_t pixel_format;
+    uint8_t bytes_per_pixel; // bytes per pixel on the wire
+    const uint8_t *palette;  // GRB palette entries of the indexed pixel formats
+    led_strip_pixel_generator_t pixel_fn; // generates the pixels instead of reading them from the primary data
+    void *pixel_ctx;
+    const uint8_t *lut[4];   // look-up table of each component in the order of G, R, B, W, or NULL if not enabled
+    size_t staged_pixel;     // index of the first pixel in the staging buffer
+    size_t staged_pixels;    // number of the pixels in the staging buffer, 0 if they must be refilled
+    uint8_t staging[LED_STRIP_ENCODER_STAGING_SIZE];
+} rmt_led_strip_encoder_t;
+
+// Number of pixels in the primary data
+static inline size_t rmt_led_strip_encoder_num_pixels(const rmt_led_strip_encoder_t *led_encoder, size_t data_size)
+{
+    if (led_encoder->palette || led_encoder->pixel_fn) {
+        // the indexed formats and the generator pass the number of pixels as the data size
+        return data_size;
+    }
+    return data_size / led_encoder->bytes_per_pixel;
+}
+
+// Get the GRB(W) bytes of one pixel from the primary data
+static inline const uint8_t *rmt_led_strip_encoder_pixel(const rmt_led_strip_encoder_t *led_encoder, const uint8_t *data, size_t index)
+{
+    switch (led_encoder->pixel_format) {
+    case LED_PIXEL_FORMAT_INDEXED8:
+        return led_encoder->palette + data[index] * 3;
+    case LED_PIXEL_FORMAT_INDEXED4:
+        // the first pixel is in the high nibble
+        return led_encoder->palette + ((data[index / 2] >> (index & 1 ? 0 : 4)) & 0x0F) * 3;
+    default:
+        return data + index * led_encoder->bytes_per_pixel;
+    }
+}
+
+// Translate the next pixels of the primary data into the staging buffer, return false if there's nothing left
+static bool rmt_led_strip_encoder_stage(rmt_led_strip_encoder_t *led_encoder, const uint8_t *data, size_t data_size)
+{
+    size_t first = led_encoder->staged_pixel + led_encoder->staged_pixels;
+    size_t num_pixels = rmt_led_strip_encoder_num_pixels(led_encoder, data_size);
+    if (first >= num_pixels) {
+        return false;
+    }
+    uint8_t bytes_per_pixel = led_encoder->bytes_per_pixel;
+    size_t count = LED_STRIP_ENCODER_STAGING_SIZE / bytes_per_pixel;
+    if (num_pixels - first < count) {
+        count = num_pixels - first;
+    }
+    uint8_t *dst = led_encoder->staging;
+    uint8_t generated[4];
+    for (size_t i = first; i < first + count; i++) {
+        const uint8_t *src = generated;
+        if (led_encoder->pixel_fn) {
+            // the color is packed in the order of the bytes on the wire, the last one in the lowest byte
+            uint32_t color = led_encoder->pixel_fn(i, led_encoder->pixel_ctx);
+            for (int c = bytes_per_pixel - 1; c >= 0; c--) {
+                generated[c] = color & 0xFF;
+                color >>= 8;
+            }
+        } else {
+            src = rmt_led_strip_encoder_pixel(led_encoder, data, i);
+        }
+        for (uint8_t c = 0; c < bytes_per_pixel; c++) {
+            *dst++ = led_encoder->lut[0] ? led_encoder->lut[c][src[c]] : src[c];
+        }
+    }
+    led_encoder->staged_pixel = first;
+    led_encoder->staged_pixels = count;
+    return true;
+}
+
+// Encode the pixels piece by piece through the staging buffer
+static size_t rmt_encode_led_strip_staged(rmt_led_strip_encoder_t *led_encoder, rmt_channel_handle_t channel,
+                                          const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
+    rmt_encode_state_t session_state = 0;
+    size_t encoded_symbols = 0;
+    *ret_state = 0;
+    while (led_encoder->staged_pixels || rmt_led_strip_encoder_stage(led_encoder, primary_data, data_size)) {
+        encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, led_encoder->staging,
+                                                 led_encoder->staged_pixels * led_encoder->bytes_per_pixel, &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            // the staged pixels have been encoded, take the next ones
+            led_encoder->staged_pixel += led_encoder->staged_pixels;
+            led_encoder->staged_pixels = 0;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            *ret_state = RMT_ENCODING_MEM_FULL;
+            if (led_encoder->staged_pixels || led_encoder->staged_pixel < rmt_led_strip_encoder_num_pixels(led_encoder, data_size)) {
+                return encoded_symbols;
+            }
+            break;
+        }
+    }
+    *ret_state |= RMT_ENCODING_COMPLETE;
+    led_encoder->staged_pixel = 0;
+    return encoded_symbols;
+}
+
+static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
+    rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
+    rmt_encode_state_t session_state = 0;
+    rmt_encode_state_t state = 0;
+    size_t encoded_symbols = 0;
+    switch (led_encoder->state) {
+    case 0: // send RGB data
+        if (led_encoder->lut[0] || led_encoder->palette || led_encoder->pixel_fn) {
+            encoded_symbols += rmt_encode_led_strip_staged(led_encoder, channel, primary_data, data_size, &session_state);
+        } else {
+            encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
+        }
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 1; // switch to next state when current encoding session finished
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    // fall-through
+    case 1: // send reset code
+        encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
+                                                sizeof(led_encoder->reset_code), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 0; // back to the initial encoding session
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    }
+out:
+    *ret_state = state;
+    return encoded_symbols;
+}
+
+static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_del_encoder(led_encoder->bytes_encoder);
+    rmt_del_encoder(led_encoder->copy_encoder);
+    free(led_encoder);
+    return ESP_OK;
+}
+
+static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_reset(led_encoder->bytes_encoder);
+    rmt_encoder_reset(led_encoder->copy_encoder);
+    led_encoder->state = 0;
+    led_encoder->staged_pixel = 0;
+    led_encoder->staged_pixels = 0;
+    return ESP_OK;
+}
+
+esp_err_t rmt_led_strip_encoder_set_lut(rmt_encoder_handle_t encoder, const led_strip_color_lut_t *lut)
+{
+    ESP_RETURN_ON_FALSE(encoder, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    if (lut) {
+        // in the order of the LED strip component
+        led_encoder->lut[0] = lut->green;
+        led_encoder->lut[1] = lut->red;
+        led_encoder->lut[2] = lut->blue;
+        led_encoder->lut[3] = lut->white;
+    } else {
+        memset(led_encoder->lut, 0, sizeof(led_encoder->lut));
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_led_strip_encoder_set_generator(rmt_encoder_handle_t encoder, led_strip_pixel_generator_t pixel_fn, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(encoder, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    ESP_RETURN_ON_FALSE(!led_encoder->palette, ESP_ERR_INVALID_STATE, TAG, "indexed pixel format can't be generated");
+    led_encoder->pixel_fn = pixel_fn;
+    led_encoder->pixel_ctx = user_ctx;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    esp_err_t ret = ESP_OK;
+    rmt_led_strip_encoder_t *led_encoder = NULL;
+    ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    bool indexed = config->led_pixel_format == LED_PIXEL_FORMAT_INDEXED8 || config->led_pixel_format == LED_PIXEL_FORMAT_INDEXED4;
+    ESP_GOTO_ON_FALSE(!indexed || config->palette, ESP_ERR_INVALID_ARG, err, TAG, "indexed pixel format requires a palette");
+    led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t));
+    ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
+    led_encoder->pixel_format = config->led_pixel_format;
+    led_encoder->bytes_per_pixel = config->led_pixel_format == LED_PIXEL_FORMAT_GRBW ? 4 : 3;
+    led_encoder->palette = indexed ? config->palette : NULL;
+    led_encoder->base.encode = rmt_encode_led_strip;
+    led_encoder->base.del = rmt_del_led_strip_encoder;
+    led_encoder->base.reset = rmt_led_strip_encoder_reset;
+    rmt_bytes_encoder_config_t bytes_encoder_config;
+    if (config->led_model == LED_MODEL_SK6812) {
+        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+            .bit0 = {
+                .level0 = 1,
+                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+                .level1 = 0,
+                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+            },
+            .bit1 = {
+                .level0 = 1,
+                .duration0 = 0.6 * config->resolution / 1000000, // T1H=0.6us
+                .level1 = 0,
+                .duration1 = 0.6 * config->resolution / 1000000, // T1L=0.6us
+            },
+            .flags.msb_first = 1 // SK6812 transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
+        };
+    } else if (config->led_model == LED_MODEL_WS2812) {
+        // different led strip might have its own timing requirements, following parameter is for WS2812
+        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+            .bit0 = {
+                .level0 = 1,
+                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+                .level1 = 0,
+                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+            },
+            .bit1 = {
+                .level0 = 1,
+                .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
+                .level1 = 0,
+                .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
+            },
+            .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
+        };
+    } else {
+        // clocked LED strips (e.g. APA102) can't be driven by the single RMT data line
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported led model");
+    }
+    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
+
+    uint32_t reset_ticks = config->resolution / 1000000 * 280 / 2; // reset code duration defaults to 280us to accomodate WS2812B-V5
+    led_encoder->reset_code = (rmt_symbol_word_t) {
+        .level0 = 0,
+        .duration0 = reset_ticks,
+        .level1 = 0,
+        .duration1 = reset_ticks,
+    };
+    *ret_encoder = &led_encoder->base;
+    return ESP_OK;
+err:
+    if (led_encoder) {
+        if (led_encoder->bytes_encoder) {
+            rmt_del_encoder(led_encoder->bytes_encoder);
+        }
+        if (led_encoder->copy_encoder) {
+            rmt_del_encoder(led_encoder->copy_encoder);
+        }
+        free(led_encoder);
+    }
+    return ret;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "driver/rmt_encoder.h"
+#include "led_strip_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of led strip encoder configuration
+ */
+typedef struct {
+    uint32_t resolution;   /*!< Encoder resolution, in Hz */
+    led_model_t led_model; /*!< LED model */
+    led_pixel_format_t led_pixel_format; /*!< LED pixel format */
+    const uint8_t *palette; /*!< GRB entries of the palette, only for the indexed pixel formats.
+                                 The encoder reads them while encoding, so they must stay valid during the transaction */
+} led_strip_encoder_config_t;
+
+/**
+ * @brief Create RMT encoder for encoding LED strip pixels into RMT symbols
+ *
+ * @note For the indexed pixel formats, the primary data holds the palette indexes and its size is the number of pixels,
+ *       because `LED_PIXEL_FORMAT_INDEXED4` packs two pixels in one byte.
+ *
+ * @param[in] config Encoder configuration
+ * @param[out] ret_encoder Returned encoder handle
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_NO_MEM out of memory when creating led strip encoder
+ *      - ESP_OK if creating encoder successfully
+ */
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+
+/**
+ * @brief Set color look-up tables, which are applied to the pixels while they're encoded
+ *
+ * @note Must not be called while the encoder is in use by a transaction
+ *
+ * @param[in] encoder LED strip encoder
+ * @param[in] lut Color look-up tables, or NULL to encode the pixels as they are
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_OK if setting the look-up tables successfully
+ */
+esp_err_t rmt_led_strip_encoder_set_lut(rmt_encoder_handle_t encoder, const led_strip_color_lut_t *lut);
+
+/**
+ * @brief Set a callback which generates the pixels while they're encoded, instead of reading them from the primary data
+ *
+ * @note The primary data is not read then, and its size is the number of pixels.
+ * @note Must not be called while the encoder is in use by a transaction
+ *
+ * @param[in] encoder LED strip encoder
+ * @param[in] pixel_fn Pixel generator, or NULL to read the pixels from the primary data again
+ * @param[in] user_ctx User context, passed to the pixel generator
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_INVALID_STATE if the encoder is for an indexed pixel format
+ *      - ESP_OK if setting the pixel generator successfully
+ */
+esp_err_t rmt_led_strip_encoder_set_generator(rmt_encoder_handle_t encoder, led_strip_pixel_generator_t pixel_fn, void *user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
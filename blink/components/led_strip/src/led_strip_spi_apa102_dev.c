@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_gpio.h"
+#include "soc/spi_periph.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_spi_apa102_dev.h"
+#include "led_strip_pixel_format.h"
+
+#define LED_STRIP_SPI_APA102_DEFAULT_CLOCK_HZ (10 * 1000 * 1000) // 10MHz
+#define LED_STRIP_SPI_APA102_TRANS_QUEUE_SIZE 4
+
+#define APA102_START_FRAME_BYTES 4
+#define APA102_BYTES_PER_PIXEL 4
+#define APA102_MAX_BRIGHTNESS 31
+// each LED delays the data by half a clock cycle, so the end frame needs max_leds / 2 more clock edges
+#define APA102_END_FRAME_BYTES(max_leds) (((max_leds) + 15) / 16)
+// SK9822 latches the new colors on a 32-bit zero frame, before the end frame
+#define SK9822_RESET_FRAME_BYTES 4
+
+static const char *TAG = "led_strip_apa102";
+
+typedef struct {
+    led_strip_t base;
+    spi_host_device_t spi_host;
+    spi_device_handle_t spi_device;
+    uint32_t strip_len;
+    size_t frame_size;  // start frame + pixels + (reset frame) + end frame
+    uint8_t pixel_buf[]; // the whole frame, each pixel in the order of 0xE0|brightness, B, G, R
+} led_strip_apa102_obj;
+
+static inline uint8_t *led_strip_apa102_pixel(led_strip_apa102_obj *apa102_strip, uint32_t index)
+{
+    return apa102_strip->pixel_buf + APA102_START_FRAME_BYTES + index * APA102_BYTES_PER_PIXEL;
+}
+
+static esp_err_t led_strip_apa102_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+    ESP_RETURN_ON_FALSE(index < apa102_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    // keep the brightness of the pixel
+    uint8_t *pixel = led_strip_apa102_pixel(apa102_strip, index);
+    pixel[1] = blue & 0xFF;
+    pixel[2] = green & 0xFF;
+    pixel[3] = red & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_apa102_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    ESP_LOGE(TAG, "wrong LED pixel format, the LED model has no white component");
+    return ESP_ERR_INVALID_ARG;
+}
+
+static esp_err_t led_strip_apa102_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+    ESP_RETURN_ON_FALSE(start <= apa102_strip->strip_len && count <= apa102_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(format == LED_COLOR_FORMAT_RGB || format == LED_COLOR_FORMAT_GRB, ESP_ERR_INVALID_ARG, TAG,
+                        "wrong LED pixel format, the LED model has no white component");
+    // the brightness byte comes first, then blue, green and red
+    const led_strip_pixel_layout_t layout = {
+        .size = APA102_BYTES_PER_PIXEL, .blue = 1, .green = 2, .red = 3, .white = LED_STRIP_PIXEL_NO_WHITE,
+    };
+    led_strip_pixel_reorder(led_strip_apa102_pixel(apa102_strip, start), layout, colors, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_apa102_set_pixel_brightness(led_strip_t *strip, uint32_t index, uint8_t brightness)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+    ESP_RETURN_ON_FALSE(index < apa102_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(brightness <= APA102_MAX_BRIGHTNESS, ESP_ERR_INVALID_ARG, TAG, "brightness out of range");
+    led_strip_apa102_pixel(apa102_strip, index)[0] = 0xE0 | brightness;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_apa102_refresh(led_strip_t *strip)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+    spi_transaction_t tx_conf;
+    memset(&tx_conf, 0, sizeof(tx_conf));
+
+    tx_conf.length = apa102_strip->frame_size * 8;
+    tx_conf.tx_buffer = apa102_strip->pixel_buf;
+    tx_conf.rx_buffer = NULL;
+    ESP_RETURN_ON_ERROR(spi_device_transmit(apa102_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_apa102_clear(led_strip_t *strip)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+    // turn off all leds, but keep their brightness
+    uint8_t *pixel = led_strip_apa102_pixel(apa102_strip, 0);
+    for (uint32_t i = 0; i < apa102_strip->strip_len; i++) {
+        memset(pixel + 1, 0, APA102_BYTES_PER_PIXEL - 1);
+        pixel += APA102_BYTES_PER_PIXEL;
+    }
+    return led_strip_apa102_refresh(strip);
+}
+
+static esp_err_t led_strip_apa102_del(led_strip_t *strip)
+{
+    led_strip_apa102_obj *apa102_strip = __containerof(strip, led_strip_apa102_obj, base);
+
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(apa102_strip->spi_device), TAG, "delete spi device failed");
+    ESP_RETURN_ON_ERROR(spi_bus_free(apa102_strip->spi_host), TAG, "free spi bus failed");
+
+    free(apa102_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_spi_apa102_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_apa102_obj *apa102_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && spi_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_model == LED_MODEL_APA102 || led_config->led_model == LED_MODEL_SK9822, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    ESP_GOTO_ON_FALSE(!spi_config->stream_chunk_leds, ESP_ERR_INVALID_ARG, err, TAG, "streaming is not supported by clocked LED strips");
+    // a zero-initialized config would silently route the clock line to GPIO0
+    ESP_GOTO_ON_FALSE(spi_config->clk_gpio_num > 0 || (spi_config->clk_gpio_num == 0 && spi_config->flags.clk_on_gpio0),
+                      ESP_ERR_INVALID_ARG, err, TAG, "clk_gpio_num must be set for clocked LED strips");
+
+    size_t frame_size = APA102_START_FRAME_BYTES + led_config->max_leds * APA102_BYTES_PER_PIXEL + APA102_END_FRAME_BYTES(led_config->max_leds);
+    if (led_config->led_model == LED_MODEL_SK9822) {
+        frame_size += SK9822_RESET_FRAME_BYTES;
+    }
+    uint32_t mem_caps = MALLOC_CAP_DEFAULT;
+    if (spi_config->flags.with_dma) {
+        // DMA buffer must be placed in internal SRAM
+        mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+    }
+    // the start, reset and end frames are all zeros
+    apa102_strip = heap_caps_calloc(1, sizeof(led_strip_apa102_obj) + frame_size, mem_caps);
+    ESP_GOTO_ON_FALSE(apa102_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for apa102 strip");
+    apa102_strip->strip_len = led_config->max_leds;
+    apa102_strip->frame_size = frame_size;
+    for (uint32_t i = 0; i < led_config->max_leds; i++) {
+        led_strip_apa102_pixel(apa102_strip, i)[0] = 0xE0 | APA102_MAX_BRIGHTNESS;
+    }
+
+    apa102_strip->spi_host = spi_config->spi_bus;
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    spi_clock_source_t clk_src = SPI_CLK_SRC_DEFAULT;
+    if (spi_config->clk_src) {
+        clk_src = spi_config->clk_src;
+    }
+
+    spi_bus_config_t spi_bus_cfg = {
+        .mosi_io_num = led_config->strip_gpio_num,
+        .miso_io_num = -1,
+        .sclk_io_num = spi_config->clk_gpio_num,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = frame_size,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(apa102_strip->spi_host, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
+
+    if (led_config->flags.invert_out == true) {
+        esp_rom_gpio_connect_out_signal(led_config->strip_gpio_num, spi_periph_signal[apa102_strip->spi_host].spid_out, true, false);
+    }
+
+    spi_device_interface_config_t spi_dev_cfg = {
+        .clock_source = clk_src,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+        .clock_speed_hz = spi_config->clock_speed_hz ? spi_config->clock_speed_hz : LED_STRIP_SPI_APA102_DEFAULT_CLOCK_HZ,
+        .mode = 0, // data is sampled on the rising edge of the clock
+        //set -1 when CS is not used
+        .spics_io_num = -1,
+        .queue_size = LED_STRIP_SPI_APA102_TRANS_QUEUE_SIZE,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_add_device(apa102_strip->spi_host, &spi_dev_cfg, &apa102_strip->spi_device), err, TAG, "Failed to add spi device");
+
+    apa102_strip->base.set_pixel = led_strip_apa102_set_pixel;
+    apa102_strip->base.set_pixel_rgbw = led_strip_apa102_set_pixel_rgbw;
+    apa102_strip->base.set_pixels = led_strip_apa102_set_pixels;
+    apa102_strip->base.set_pixel_brightness = led_strip_apa102_set_pixel_brightness;
+    apa102_strip->base.refresh = led_strip_apa102_refresh;
+    apa102_strip->base.clear = led_strip_apa102_clear;
+    apa102_strip->base.del = led_strip_apa102_del;
+
+    *ret_strip = &apa102_strip->base;
+    return ESP_OK;
+err:
+    if (apa102_strip) {
+        if (apa102_strip->spi_device) {
+            spi_bus_remove_device(apa102_strip->spi_device);
+        }
+        if (apa102_strip->spi_host) {
+            spi_bus_free(apa102_strip->spi_host);
+        }
+        free(apa102_strip);
+    }
+    return ret;
+}
@@ -0,0 +1,308 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_gpio.h"
+#include "soc/spi_periph.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_spi_encoder.h"
+#include "led_strip_pixel_format.h"
+#include "led_strip_spi_apa102_dev.h"
+#include "hal/spi_hal.h"
+
+#define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
+#define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
+
+#define SPI_BYTES_PER_COLOR_BYTE LED_STRIP_SPI_BYTES_PER_COLOR_BYTE
+#define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
+
+static const char *TAG = "led_strip_spi";
+
+typedef struct {
+    led_strip_t base;
+    spi_host_device_t spi_host;
+    spi_device_handle_t spi_device;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    uint32_t stream_chunk_leds;     // 0: the whole strip is encoded into frame_buf, otherwise: it's streamed through stream_buf
+    uint8_t *frame_buf;             // SPI waveform of the whole strip, only when not streaming
+    uint8_t *stream_buf[2];         // DMA bounce buffers, each holds the SPI waveform of stream_chunk_leds LEDs
+    spi_transaction_t stream_trans[2];
+    const uint8_t *lut[4];          // look-up table of each component in the order of G, R, B, W, or NULL if not enabled
+    uint8_t pixel_buf[];            // GRB(W) bytes, encoded when the strip is refreshed
+} led_strip_spi_obj;
+
+// Encode len color bytes of pixel_buf from offset, which is at a pixel boundary, into the SPI waveform in buf
+static void led_strip_spi_encode(led_strip_spi_obj *spi_strip, uint32_t offset, uint32_t len, uint8_t *buf)
+{
+    led_strip_spi_encode_bytes(spi_strip->pixel_buf + offset, len, spi_strip->lut[0] ? spi_strip->lut : NULL,
+                               spi_strip->bytes_per_pixel, buf);
+}
+
+static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    // LED_PIXEL_FORMAT_GRB takes 72bits(9bytes) once encoded
+    uint8_t *pixel = spi_strip->pixel_buf + index * spi_strip->bytes_per_pixel;
+    pixel[0] = green & 0xFF;
+    pixel[1] = red & 0xFF;
+    pixel[2] = blue & 0xFF;
+    if (spi_strip->bytes_per_pixel > 3) {
+        pixel[3] = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes) once encoded
+    uint8_t *pixel = spi_strip->pixel_buf + index * 4;
+    // SK6812 component order is GRBW
+    pixel[0] = green & 0xFF;
+    pixel[1] = red & 0xFF;
+    pixel[2] = blue & 0xFF;
+    pixel[3] = white & 0xFF;
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *colors, led_color_format_t format)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG,
+                        "pixel range out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(led_strip_color_format_bytes(format) <= spi_strip->bytes_per_pixel, ESP_ERR_INVALID_ARG, TAG,
+                        "color format has a white component but the strip has none");
+    led_strip_pixel_reorder(spi_strip->pixel_buf + start * spi_strip->bytes_per_pixel, LED_STRIP_PIXEL_LAYOUT_GRB(spi_strip->bytes_per_pixel), colors, count, format);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_stream_refresh(led_strip_spi_obj *spi_strip)
+{
+    esp_err_t ret = ESP_OK;
+    spi_transaction_t *done_trans = NULL;
+    uint32_t chunk_bytes = spi_strip->stream_chunk_leds * spi_strip->bytes_per_pixel;
+    uint32_t total_bytes = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+    int in_flight = 0;
+
+    // keep the bus for the whole frame, so the chunks are sent back to back
+    ESP_RETURN_ON_ERROR(spi_device_acquire_bus(spi_strip->spi_device, portMAX_DELAY), TAG, "acquire SPI bus failed");
+    for (uint32_t offset = 0, i = 0; offset < total_bytes; offset += chunk_bytes, i ^= 1) {
+        if (in_flight == 2) {
+            // wait for the bounce buffer to be free again
+            ESP_GOTO_ON_ERROR(spi_device_get_trans_result(spi_strip->spi_device, &done_trans, portMAX_DELAY), out, TAG, "wait SPI transaction failed");
+            in_flight--;
+        }
+        uint32_t len = total_bytes - offset < chunk_bytes ? total_bytes - offset : chunk_bytes;
+        uint8_t *buf = spi_strip->stream_buf[i];
+        // chunks always start at a pixel boundary
+        led_strip_spi_encode(spi_strip, offset, len, buf);
+        spi_transaction_t *trans = &spi_strip->stream_trans[i];
+        memset(trans, 0, sizeof(spi_transaction_t));
+        trans->length = len * SPI_BITS_PER_COLOR_BYTE;
+        trans->tx_buffer = buf;
+        ESP_GOTO_ON_ERROR(spi_device_queue_trans(spi_strip->spi_device, trans, portMAX_DELAY), out, TAG, "queue SPI transaction failed");
+        in_flight++;
+    }
+out:
+    // drain the transactions still in flight, even if something went wrong
+    while (in_flight--) {
+        spi_device_get_trans_result(spi_strip->spi_device, &done_trans, portMAX_DELAY);
+    }
+    spi_device_release_bus(spi_strip->spi_device);
+    return ret;
+}
+
+static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    if (spi_strip->stream_chunk_leds) {
+        ESP_RETURN_ON_ERROR(led_strip_spi_stream_refresh(spi_strip), TAG, "stream pixels by SPI failed");
+        return ESP_OK;
+    }
+
+    uint32_t frame_bytes = spi_strip->strip_len * spi_strip->bytes_per_pixel;
+    led_strip_spi_encode(spi_strip, 0, frame_bytes, spi_strip->frame_buf);
+
+    spi_transaction_t tx_conf;
+    memset(&tx_conf, 0, sizeof(tx_conf));
+
+    tx_conf.length = frame_bytes * SPI_BITS_PER_COLOR_BYTE;
+    tx_conf.tx_buffer = spi_strip->frame_buf;
+    tx_conf.rx_buffer = NULL;
+    ESP_RETURN_ON_ERROR(spi_device_transmit(spi_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_color_lut(led_strip_t *strip, const led_strip_color_lut_t *lut)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    // refresh is blocking, so no frame is being encoded now
+    if (lut) {
+        spi_strip->lut[0] = lut->green;
+        spi_strip->lut[1] = lut->red;
+        spi_strip->lut[2] = lut->blue;
+        spi_strip->lut[3] = lut->white;
+    } else {
+        memset(spi_strip->lut, 0, sizeof(spi_strip->lut));
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_clear(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    //Write zero to turn off all leds
+    memset(spi_strip->pixel_buf, 0, spi_strip->strip_len * spi_strip->bytes_per_pixel);
+
+    return led_strip_spi_refresh(strip);
+}
+
+static esp_err_t led_strip_spi_del(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi_strip->spi_device), TAG, "delete spi device failed");
+    ESP_RETURN_ON_ERROR(spi_bus_free(spi_strip->spi_host), TAG, "free spi bus failed");
+
+    free(spi_strip->frame_buf);
+    free(spi_strip->stream_buf[0]);
+    free(spi_strip->stream_buf[1]);
+    free(spi_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_spi_obj *spi_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && spi_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    if (led_config->led_model == LED_MODEL_APA102 || led_config->led_model == LED_MODEL_SK9822) {
+        // clocked LED strips take the pixels as they are
+        return led_strip_new_spi_apa102_device(led_config, spi_config, ret_strip);
+    }
+    ESP_GOTO_ON_FALSE(led_config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    ESP_GOTO_ON_FALSE(!spi_config->stream_chunk_leds || spi_config->flags.with_dma, ESP_ERR_INVALID_ARG, err, TAG, "streaming requires DMA");
+    uint8_t bytes_per_pixel = 3;
+    if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
+        bytes_per_pixel = 4;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
+        bytes_per_pixel = 3;
+    } else {
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "indexed pixel format is not supported");
+    }
+    uint32_t stream_chunk_leds = spi_config->stream_chunk_leds;
+    if (stream_chunk_leds > led_config->max_leds) {
+        stream_chunk_leds = led_config->max_leds;
+    }
+    uint32_t mem_caps = MALLOC_CAP_DEFAULT;
+    if (spi_config->flags.with_dma) {
+        // DMA buffer must be placed in internal SRAM
+        mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+    }
+    // the GRB(W) bytes, encoded into the waveform of the whole strip, or of a chunk when streaming
+    size_t pixel_buf_size = led_config->max_leds * bytes_per_pixel;
+    size_t max_transfer_sz = pixel_buf_size * SPI_BYTES_PER_COLOR_BYTE;
+    if (stream_chunk_leds) {
+        max_transfer_sz = stream_chunk_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    }
+    spi_strip = calloc(1, sizeof(led_strip_spi_obj) + pixel_buf_size);
+
+    ESP_GOTO_ON_FALSE(spi_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip");
+
+    if (!stream_chunk_leds) {
+        spi_strip->frame_buf = heap_caps_malloc(max_transfer_sz, mem_caps);
+        ESP_GOTO_ON_FALSE(spi_strip->frame_buf, ESP_ERR_NO_MEM, err, TAG, "no mem for frame buffer");
+    } else {
+        for (int i = 0; i < 2; i++) {
+            spi_strip->stream_buf[i] = heap_caps_malloc(max_transfer_sz, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+            ESP_GOTO_ON_FALSE(spi_strip->stream_buf[i], ESP_ERR_NO_MEM, err, TAG, "no mem for stream buffer");
+        }
+    }
+
+    spi_strip->spi_host = spi_config->spi_bus;
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    spi_clock_source_t clk_src = SPI_CLK_SRC_DEFAULT;
+    if (spi_config->clk_src) {
+        clk_src = spi_config->clk_src;
+    }
+
+    spi_bus_config_t spi_bus_cfg = {
+        .mosi_io_num = led_config->strip_gpio_num,
+        //Only use MOSI to generate the signal, set -1 when other pins are not used.
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = max_transfer_sz,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(spi_strip->spi_host, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
+
+    if (led_config->flags.invert_out == true) {
+        esp_rom_gpio_connect_out_signal(led_config->strip_gpio_num, spi_periph_signal[spi_strip->spi_host].spid_out, true, false);
+    }
+
+    spi_device_interface_config_t spi_dev_cfg = {
+        .clock_source = clk_src,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+        .clock_speed_hz = LED_STRIP_SPI_DEFAULT_RESOLUTION,
+        .mode = 0,
+        //set -1 when CS is not used
+        .spics_io_num = -1,
+        .queue_size = LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE,
+    };
+
+    ESP_GOTO_ON_ERROR(spi_bus_add_device(spi_strip->spi_host, &spi_dev_cfg, &spi_strip->spi_device), err, TAG, "Failed to add spi device");
+    //ensure the reset time is enough
+    esp_rom_delay_us(10);
+    int clock_resolution_khz = 0;
+    spi_device_get_actual_freq(spi_strip->spi_device, &clock_resolution_khz);
+    // TODO: ideally we should decide the SPI_BYTES_PER_COLOR_BYTE by the real clock resolution
+    // But now, let's fixed the resolution, the downside is, we don't support a clock source whose frequency is not multiple of LED_STRIP_SPI_DEFAULT_RESOLUTION
+    // clock_resolution between 2.2MHz to 2.8MHz is supported
+    ESP_GOTO_ON_FALSE((clock_resolution_khz < LED_STRIP_SPI_DEFAULT_RESOLUTION / 1000 + 300) && (clock_resolution_khz > LED_STRIP_SPI_DEFAULT_RESOLUTION / 1000 - 300), ESP_ERR_NOT_SUPPORTED, err,
+                      TAG, "unsupported clock resolution:%dKHz", clock_resolution_khz);
+
+    spi_strip->bytes_per_pixel = bytes_per_pixel;
+    spi_strip->strip_len = led_config->max_leds;
+    spi_strip->stream_chunk_leds = stream_chunk_leds;
+    spi_strip->base.set_pixel = led_strip_spi_set_pixel;
+    spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+    spi_strip->base.refresh = led_strip_spi_refresh;
+    spi_strip->base.set_color_lut = led_strip_spi_set_color_lut;
+    spi_strip->base.clear = led_strip_spi_clear;
+    spi_strip->base.del = led_strip_spi_del;
+
+    *ret_strip = &spi_strip->base;
+    return ESP_OK;
+err:
+    if (spi_strip) {
+        if (spi_strip->spi_device) {
+            spi_bus_remove_device(spi_strip->spi_device);
+        }
+        if (spi_strip->spi_host) {
+            spi_bus_free(spi_strip->spi_host);
+        }
+        free(spi_strip->frame_buf);
+        free(spi_strip->stream_buf[0]);
+        free(spi_strip->stream_buf[1]);
+        free(spi_strip);
+    }
+    return ret;
+}
@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "led_strip_spi_encoder.h"
+
+#if CONFIG_LED_STRIP_SPI_ENCODE_TABLE_IN_DRAM
+#define LED_STRIP_SPI_ENCODE_TABLE_ATTR DRAM_ATTR
+#else
+#define LED_STRIP_SPI_ENCODE_TABLE_ATTR
+#endif
+
+// Bit 7 of the color byte is sent first, each bit becomes 1x0 on the wire, where x is the bit value:
+// byte 0: 1 b7 0 1 b6 0 1 b5
+// byte 1: 0 1 b4 0 1 b3 0 1
+// byte 2: b2 0 1 b1 0 1 b0 0
+#define SPI_BIT(data, n, pos) ((((data) >> (n)) & 0x01) << (pos))
+#define SPI_ENCODE(d) {                                                   \
+    0x92 | SPI_BIT(d, 7, 6) | SPI_BIT(d, 6, 3) | SPI_BIT(d, 5, 0),        \
+    0x49 | SPI_BIT(d, 4, 5) | SPI_BIT(d, 3, 2),                           \
+    0x24 | SPI_BIT(d, 2, 7) | SPI_BIT(d, 1, 4) | SPI_BIT(d, 0, 1),        \
+}
+#define SPI_ENCODE_4(d)   SPI_ENCODE(d), SPI_ENCODE((d) + 1), SPI_ENCODE((d) + 2), SPI_ENCODE((d) + 3)
+#define SPI_ENCODE_16(d)  SPI_ENCODE_4(d), SPI_ENCODE_4((d) + 4), SPI_ENCODE_4((d) + 8), SPI_ENCODE_4((d) + 12)
+#define SPI_ENCODE_64(d)  SPI_ENCODE_16(d), SPI_ENCODE_16((d) + 16), SPI_ENCODE_16((d) + 32), SPI_ENCODE_16((d) + 48)
+
+const LED_STRIP_SPI_ENCODE_TABLE_ATTR uint8_t led_strip_spi_encode_table[256][LED_STRIP_SPI_BYTES_PER_COLOR_BYTE] = {
+    SPI_ENCODE_64(0), SPI_ENCODE_64(64), SPI_ENCODE_64(128), SPI_ENCODE_64(192),
+};
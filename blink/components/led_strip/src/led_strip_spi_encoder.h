@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of SPI bytes used to send one color byte
+ *
+ * Each color bit is represented by 3 bits of SPI, low_level:100, high_level:110
+ */
+#define LED_STRIP_SPI_BYTES_PER_COLOR_BYTE 3
+
+/**
+ * @brief SPI waveform of every possible color byte, indexed by the color byte
+ */
+extern const uint8_t led_strip_spi_encode_table[256][LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+
+/**
+ * @brief Encode one color byte into its SPI waveform
+ *
+ * @param[in] data Color byte
+ * @param[out] buf Buffer to hold the `LED_STRIP_SPI_BYTES_PER_COLOR_BYTE` bytes of SPI waveform
+ */
+static inline void led_strip_spi_encode_byte(uint8_t data, uint8_t *buf)
+{
+    const uint8_t *pattern = led_strip_spi_encode_table[data];
+    buf[0] = pattern[0];
+    buf[1] = pattern[1];
+    buf[2] = pattern[2];
+}
+
+/**
+ * @brief Encode color bytes into their SPI waveform, mapping them by look-up tables first
+ *
+ * @param[in] data Color bytes, starting at the first component of a pixel
+ * @param[in] len Number of color bytes
+ * @param[in] lut Look-up table of each component of a pixel, or NULL to encode the bytes as they are
+ * @param[in] bytes_per_pixel Number of components of a pixel, which is also the number of look-up tables
+ * @param[out] buf Buffer to hold `len * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE` bytes of SPI waveform
+ */
+static inline void led_strip_spi_encode_bytes(const uint8_t *data, uint32_t len, const uint8_t *const *lut,
+                                              uint8_t bytes_per_pixel, uint8_t *buf)
+{
+    if (lut) {
+        for (uint32_t j = 0; j < len; j++) {
+            led_strip_spi_encode_byte(lut[j % bytes_per_pixel][data[j]], buf + j * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+        }
+    } else {
+        for (uint32_t j = 0; j < len; j++) {
+            led_strip_spi_encode_byte(data[j], buf + j * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
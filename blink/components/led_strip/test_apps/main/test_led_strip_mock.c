@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "led_strip.h"
+#include "led_strip_spi_encoder.h"
+
+#define TEST_LED_NUM 4
+
+static led_strip_handle_t test_new_mock_strip(void)
+{
+    led_strip_config_t strip_config = {
+        .max_leds = TEST_LED_NUM,
+        .led_model = LED_MODEL_WS2812,
+        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
+    };
+    led_strip_mock_config_t mock_config = {
+        .sink = LED_STRIP_MOCK_SINK_SPI,
+    };
+    led_strip_handle_t strip = NULL;
+    TEST_ESP_OK(led_strip_new_mock_device(&strip_config, &mock_config, &strip));
+    return strip;
+}
+
+static void test_set_all(led_strip_handle_t strip, uint8_t red, uint8_t green, uint8_t blue)
+{
+    for (int i = 0; i < TEST_LED_NUM; i++) {
+        TEST_ESP_OK(led_strip_set_pixel(strip, i, red, green, blue));
+    }
+}
+
+// check the SPI waveform of the last frame sent out shows all pixels in the given color
+static void test_check_sink(led_strip_handle_t strip, uint8_t red, uint8_t green, uint8_t blue)
+{
+    const uint8_t grb[3] = {green, red, blue};
+    uint8_t expected[TEST_LED_NUM * 3 * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+    for (size_t i = 0; i < sizeof(expected) / LED_STRIP_SPI_BYTES_PER_COLOR_BYTE; i++) {
+        led_strip_spi_encode_byte(grb[i % 3], &expected[i * LED_STRIP_SPI_BYTES_PER_COLOR_BYTE]);
+    }
+    const void *data = NULL;
+    size_t size = 0;
+    TEST_ESP_OK(led_strip_mock_get_sink(strip, &data, &size));
+    TEST_ASSERT_EQUAL(sizeof(expected), size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, size);
+}
+
+static bool test_count_refresh_done(led_strip_handle_t strip, void *user_ctx)
+{
+    (*(int *)user_ctx)++;
+    return false;
+}
+
+TEST_CASE("mock strip renders the next frame while the current one is sent out", "[led_strip][mock]")
+{
+    led_strip_handle_t strip = test_new_mock_strip();
+    int done_count = 0;
+    led_strip_event_callbacks_t cbs = {
+        .on_refresh_done = test_count_refresh_done,
+    };
+    TEST_ESP_OK(led_strip_register_event_callbacks(strip, &cbs, &done_count));
+
+    test_set_all(strip, 0xFF, 0x00, 0x00);
+    TEST_ESP_OK(led_strip_refresh_async(strip));
+    // render the next frame while the first one is on the wire
+    test_set_all(strip, 0x00, 0x00, 0xA5);
+    TEST_ASSERT_EQUAL(0, done_count);
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, -1));
+    TEST_ASSERT_EQUAL(1, done_count);
+    // the first frame went out as it was when the refresh started
+    test_check_sink(strip, 0xFF, 0x00, 0x00);
+
+    TEST_ESP_OK(led_strip_refresh_async(strip));
+    test_set_all(strip, 0x12, 0x34, 0x56);
+    // starting a frame waits for the one still on the wire
+    TEST_ESP_OK(led_strip_refresh_async(strip));
+    TEST_ASSERT_EQUAL(2, done_count);
+    test_check_sink(strip, 0x00, 0x00, 0xA5);
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, -1));
+    TEST_ASSERT_EQUAL(3, done_count);
+    test_check_sink(strip, 0x12, 0x34, 0x56);
+
+    // nothing pending, waiting returns at once
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, 0));
+    TEST_ASSERT_EQUAL(3, done_count);
+
+    TEST_ESP_OK(led_strip_refresh(strip));
+    TEST_ASSERT_EQUAL(4, done_count);
+    test_check_sink(strip, 0x12, 0x34, 0x56);
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("mock strip reorders the pixels of every color format", "[led_strip][mock]")
+{
+    led_strip_handle_t strip = test_new_mock_strip();
+    const uint8_t rgb[] = {0x11, 0x22, 0x33, 0x11, 0x22, 0x33, 0x11, 0x22, 0x33, 0x11, 0x22, 0x33};
+    TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LED_NUM, rgb, LED_COLOR_FORMAT_RGB));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    test_check_sink(strip, 0x11, 0x22, 0x33);
+
+    const uint8_t grb[] = {0x22, 0x11, 0x33, 0x22, 0x11, 0x33, 0x22, 0x11, 0x33, 0x22, 0x11, 0x33};
+    TEST_ESP_OK(led_strip_clear(strip));
+    TEST_ESP_OK(led_strip_set_pixels(strip, 0, TEST_LED_NUM, grb, LED_COLOR_FORMAT_GRB));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    test_check_sink(strip, 0x11, 0x22, 0x33);
+
+    // the strip has no white component
+    const uint8_t rgbw[] = {0x11, 0x22, 0x33, 0x44};
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, 0, 1, rgbw, LED_COLOR_FORMAT_RGBW));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, led_strip_set_pixels(strip, 1, TEST_LED_NUM, rgb, LED_COLOR_FORMAT_RGB));
+    TEST_ESP_OK(led_strip_del(strip));
+}
+
+TEST_CASE("mock strip maps the colors by the look-up tables when sending them out", "[led_strip][mock]")
+{
+    led_strip_handle_t strip = test_new_mock_strip();
+    // the tables are not copied, they have to outlive the strip
+    static led_strip_color_lut_t lut;
+    for (int i = 0; i < 256; i++) {
+        lut.red[i] = 0xFF - i;
+        lut.green[i] = i / 2;
+        lut.blue[i] = i * i / 255;
+    }
+
+    test_set_all(strip, 0x12, 0x34, 0x56);
+    TEST_ESP_OK(led_strip_refresh_async(strip));
+    // the frame still on the wire goes out with the tables it was started with
+    TEST_ESP_OK(led_strip_set_color_lut(strip, &lut));
+    test_check_sink(strip, 0x12, 0x34, 0x56);
+    TEST_ESP_OK(led_strip_refresh_wait_done(strip, -1));
+    test_check_sink(strip, 0x12, 0x34, 0x56);
+
+    TEST_ESP_OK(led_strip_refresh(strip));
+    test_check_sink(strip, lut.red[0x12], lut.green[0x34], lut.blue[0x56]);
+
+    // the pixels in memory are left as they were set
+    TEST_ESP_OK(led_strip_set_color_lut(strip, NULL));
+    TEST_ESP_OK(led_strip_refresh(strip));
+    test_check_sink(strip, 0x12, 0x34, 0x56);
+    TEST_ESP_OK(led_strip_del(strip));
+}
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+#include "led_strip_spi_encoder.h"
+
+#define TEST_BIT(n) (1 << (n))
+
+// The per-bit encoder the SPI backend used before the look-up table, kept as the reference
+static void test_spi_encode_bit_by_bit(uint8_t data, uint8_t *buf)
+{
+    memset(buf, 0, LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+    *(buf + 2) |= data & TEST_BIT(0) ? TEST_BIT(2) | TEST_BIT(1) : TEST_BIT(2);
+    *(buf + 2) |= data & TEST_BIT(1) ? TEST_BIT(5) | TEST_BIT(4) : TEST_BIT(5);
+    *(buf + 2) |= data & TEST_BIT(2) ? TEST_BIT(7) : 0x00;
+    *(buf + 1) |= TEST_BIT(0);
+    *(buf + 1) |= data & TEST_BIT(3) ? TEST_BIT(3) | TEST_BIT(2) : TEST_BIT(3);
+    *(buf + 1) |= data & TEST_BIT(4) ? TEST_BIT(6) | TEST_BIT(5) : TEST_BIT(6);
+    *(buf + 0) |= data & TEST_BIT(5) ? TEST_BIT(1) | TEST_BIT(0) : TEST_BIT(1);
+    *(buf + 0) |= data & TEST_BIT(6) ? TEST_BIT(4) | TEST_BIT(3) : TEST_BIT(4);
+    *(buf + 0) |= data & TEST_BIT(7) ? TEST_BIT(7) | TEST_BIT(6) : TEST_BIT(7);
+}
+
+TEST_CASE("SPI encode table matches the bit by bit encoder", "[led_strip][spi]")
+{
+    for (int data = 0; data < 256; data++) {
+        uint8_t expected[LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+        uint8_t encoded[LED_STRIP_SPI_BYTES_PER_COLOR_BYTE];
+        test_spi_encode_bit_by_bit(data, expected);
+        led_strip_spi_encode_byte(data, encoded);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, encoded, LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, led_strip_spi_encode_table[data], LED_STRIP_SPI_BYTES_PER_COLOR_BYTE);
+    }
+}
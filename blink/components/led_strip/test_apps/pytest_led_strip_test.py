@@ -0,0 +1,12 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+
+
+@pytest.mark.linux
+@pytest.mark.host_test
+def test_led_strip(dut: IdfDut) -> None:
+    result = dut.expect(r'(\d+) Tests (\d+) Failures (\d+) Ignored', timeout=60)
+    assert int(result.group(1)) > 0
+    assert int(result.group(2)) == 0